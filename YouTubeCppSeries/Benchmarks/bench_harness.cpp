@@ -0,0 +1,534 @@
+#include "bench_harness.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+
+#include <fmt/format.h>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace bench
+{
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	/*
+	* The code under test often prints (that is what the episodes do).
+	* While measuring, stdout is pointed at the null device so the terminal
+	* does not become the benchmark.
+	*/
+	class StdoutSilencer
+	{
+	public:
+		StdoutSilencer()
+		{
+			std::cout.flush();
+			std::fflush(stdout);
+#if defined(_WIN32)
+			m_SavedFd = _dup(1);
+			const int nullFd = _open("NUL", _O_WRONLY);
+			_dup2(nullFd, 1);
+			_close(nullFd);
+#else
+			m_SavedFd = dup(1);
+			const int nullFd = open("/dev/null", O_WRONLY);
+			dup2(nullFd, 1);
+			close(nullFd);
+#endif
+		}
+
+		~StdoutSilencer()
+		{
+			std::cout.flush();
+			std::fflush(stdout);
+#if defined(_WIN32)
+			_dup2(m_SavedFd, 1);
+			_close(m_SavedFd);
+#else
+			dup2(m_SavedFd, 1);
+			close(m_SavedFd);
+#endif
+		}
+
+		StdoutSilencer(const StdoutSilencer&) = delete;
+		StdoutSilencer& operator=(const StdoutSilencer&) = delete;
+
+	private:
+		int m_SavedFd{ -1 };
+	};
+
+	/*
+	* Hardware counters through perf_event_open (Linux only).
+	* Only user space is counted, so this works with the default perf_event_paranoid.
+	* Counters the machine does not expose (common in VMs) are skipped.
+	*/
+	class PerfCounters
+	{
+	public:
+		PerfCounters()
+		{
+#if defined(__linux__)
+			const std::pair<const char*, std::uint64_t> events[]{
+				{ "cycles", PERF_COUNT_HW_CPU_CYCLES },
+				{ "instructions", PERF_COUNT_HW_INSTRUCTIONS },
+				{ "cache-misses", PERF_COUNT_HW_CACHE_MISSES },
+				{ "branch-misses", PERF_COUNT_HW_BRANCH_MISSES },
+			};
+
+			for (const auto& [name, config] : events)
+			{
+				perf_event_attr attr{};
+				attr.size = sizeof(attr);
+				attr.type = PERF_TYPE_HARDWARE;
+				attr.config = config;
+				attr.disabled = 1;
+				attr.exclude_kernel = 1;
+				attr.exclude_hv = 1;
+				attr.inherit = 1;
+				attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+				const int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+				if (fd >= 0)
+					m_Counters.push_back({ name, fd });
+			}
+#endif
+		}
+
+		~PerfCounters()
+		{
+#if defined(__linux__)
+			for (const auto& counter : m_Counters)
+				close(counter.fd);
+#endif
+		}
+
+		PerfCounters(const PerfCounters&) = delete;
+		PerfCounters& operator=(const PerfCounters&) = delete;
+
+		bool IsAvailable() const { return !m_Counters.empty(); }
+
+		void Start()
+		{
+#if defined(__linux__)
+			for (const auto& counter : m_Counters)
+			{
+				ioctl(counter.fd, PERF_EVENT_IOC_RESET, 0);
+				ioctl(counter.fd, PERF_EVENT_IOC_ENABLE, 0);
+			}
+#endif
+		}
+
+		void Stop()
+		{
+#if defined(__linux__)
+			for (const auto& counter : m_Counters)
+				ioctl(counter.fd, PERF_EVENT_IOC_DISABLE, 0);
+#endif
+		}
+
+		/* Counter totals since Start(), scaled up if the kernel had to multiplex them. */
+		std::vector<std::pair<std::string, double>> Read() const
+		{
+			std::vector<std::pair<std::string, double>> values;
+#if defined(__linux__)
+			for (const auto& counter : m_Counters)
+			{
+				std::uint64_t data[3]{};
+				if (read(counter.fd, data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)) || data[2] == 0)
+					continue;
+
+				values.emplace_back(counter.name,
+					static_cast<double>(data[0]) * static_cast<double>(data[1]) / static_cast<double>(data[2]));
+			}
+#endif
+			return values;
+		}
+
+	private:
+		struct Counter
+		{
+			const char* name;
+			int fd;
+		};
+
+		std::vector<Counter> m_Counters;
+	};
+
+	bool PinToCpu(int cpu)
+	{
+#if defined(__linux__)
+		if (cpu < 0)
+			cpu = sched_getcpu();
+		if (cpu < 0)
+			return false;
+
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+		(void)cpu;
+		return false;
+#endif
+	}
+
+	double ElapsedNs(Clock::time_point start, Clock::time_point end)
+	{
+		return std::chrono::duration<double, std::nano>(end - start).count();
+	}
+
+	bool StartsWith(std::string_view text, std::string_view prefix)
+	{
+		return text.substr(0, prefix.size()) == prefix;
+	}
+
+	void PrintUsage(const std::string& suiteName)
+	{
+		fmt::print(
+			"Usage: {} [options]\n"
+			"  --filter=<text>       Only run benchmarks whose name contains <text>\n"
+			"  --reps=<n>            Timed repetitions (default 15)\n"
+			"  --warmup=<n>          Warm-up repetitions (default 2)\n"
+			"  --min-time-ms=<n>     Minimum duration of one repetition (default 20)\n"
+			"  --cpu=<n>             Pin to CPU <n> (default: the CPU we start on)\n"
+			"  --no-pin              Do not pin to a CPU\n"
+			"  --json=<path>         Write results as JSON\n"
+			"  --baseline=<path>     Compare medians against a stored baseline\n"
+			"  --update-baseline     Overwrite the baseline with these results\n"
+			"  --threshold=<ratio>   Allowed slowdown before flagging a regression (default 0.10)\n",
+			suiteName);
+	}
+
+	/* The number after the '=' in "--name=<number>". Bad input is a usage error, not an exception. */
+	template <typename T>
+	T ParseValue(std::string_view arg, const std::string& suiteName)
+	{
+		const std::string_view text = arg.substr(arg.find('=') + 1);
+		T value{};
+		const auto [pEnd, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+		if (error != std::errc{} || pEnd != text.data() + text.size())
+		{
+			fmt::print(stderr, "Invalid value in '{}'\n", arg);
+			PrintUsage(suiteName);
+			std::exit(2);
+		}
+		return value;
+	}
+
+	std::string EscapeJson(std::string_view text)
+	{
+		std::string escaped;
+		escaped.reserve(text.size());
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\')
+				escaped.push_back('\\');
+			escaped.push_back(c);
+		}
+		return escaped;
+	}
+}
+
+Runner::Runner(std::string suiteName, int argc, char** argv)
+	: m_SuiteName{ std::move(suiteName) }
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string_view arg{ argv[i] };
+		auto value = [&arg] { return std::string{ arg.substr(arg.find('=') + 1) }; };
+
+		if (StartsWith(arg, "--filter="))
+			m_Options.filter = value();
+		else if (StartsWith(arg, "--reps="))
+			m_Options.repetitions = std::max(1, ParseValue<int>(arg, m_SuiteName));
+		else if (StartsWith(arg, "--warmup="))
+			m_Options.warmupRepetitions = std::max(0, ParseValue<int>(arg, m_SuiteName));
+		else if (StartsWith(arg, "--min-time-ms="))
+			m_Options.minTimeMs = std::max(1, ParseValue<int>(arg, m_SuiteName));
+		else if (StartsWith(arg, "--cpu="))
+			m_Options.cpu = ParseValue<int>(arg, m_SuiteName);
+		else if (arg == "--no-pin")
+			m_Options.bPin = false;
+		else if (StartsWith(arg, "--json="))
+			m_Options.jsonPath = value();
+		else if (StartsWith(arg, "--baseline="))
+			m_Options.baselinePath = value();
+		else if (arg == "--update-baseline")
+			m_Options.bUpdateBaseline = true;
+		else if (StartsWith(arg, "--threshold="))
+			m_Options.threshold = ParseValue<double>(arg, m_SuiteName);
+		else
+		{
+			PrintUsage(m_SuiteName);
+			std::exit(arg == "--help" ? 0 : 2);
+		}
+	}
+}
+
+void Runner::AddBatch(std::string name, std::function<void(std::uint64_t)> batch)
+{
+	m_Benchmarks.push_back({ std::move(name), std::move(batch) });
+}
+
+Result Runner::Measure(const Benchmark& benchmark)
+{
+	const double minTimeNs = m_Options.minTimeMs * 1'000'000.0;
+
+	StdoutSilencer silencer{};
+
+	// Find an iteration count that makes one repetition last at least minTimeNs
+	std::uint64_t iterations{ 1 };
+	for (;;)
+	{
+		const auto start = Clock::now();
+		benchmark.batch(iterations);
+		const double elapsed = ElapsedNs(start, Clock::now());
+
+		if (elapsed >= minTimeNs || iterations >= (1ull << 40))
+			break;
+
+		const double scale = elapsed > 0.0 ? minTimeNs * 1.2 / elapsed : 10.0;
+		iterations = static_cast<std::uint64_t>(static_cast<double>(iterations) * std::clamp(scale, 2.0, 10.0));
+	}
+
+	for (int i = 0; i < m_Options.warmupRepetitions; ++i)
+		benchmark.batch(iterations);
+
+	PerfCounters counters{};
+	std::vector<double> samples;
+	samples.reserve(static_cast<std::size_t>(m_Options.repetitions));
+
+	counters.Start();
+	for (int i = 0; i < m_Options.repetitions; ++i)
+	{
+		const auto start = Clock::now();
+		benchmark.batch(iterations);
+		const auto end = Clock::now();
+		samples.push_back(ElapsedNs(start, end) / static_cast<double>(iterations));
+	}
+	counters.Stop();
+
+	Result result = Summarize(benchmark.name, iterations, std::move(samples));
+
+	const double operations = static_cast<double>(iterations) * m_Options.repetitions;
+	for (auto& [name, total] : counters.Read())
+		result.counters.emplace_back(name, total / operations);
+
+	return result;
+}
+
+int Runner::Run()
+{
+	const bool bPinned = m_Options.bPin && PinToCpu(m_Options.cpu);
+	fmt::print("Suite: {} ({} reps, {} warm-up, {}ms min per rep{})\n",
+		m_SuiteName, m_Options.repetitions, m_Options.warmupRepetitions, m_Options.minTimeMs,
+		bPinned ? ", pinned" : "");
+
+	if (!PerfCounters{}.IsAvailable())
+		fmt::print("Hardware counters are not available (perf_event_open failed), timing only.\n");
+
+	fmt::print("{:<44} {:>12} {:>12} {:>12} {:>12} {:>10}\n", "Benchmark", "median ns", "p99 ns", "max ns", "stddev ns", "iters");
+
+	std::vector<Result> results;
+	for (const auto& benchmark : m_Benchmarks)
+	{
+		if (!m_Options.filter.empty() && benchmark.name.find(m_Options.filter) == std::string::npos)
+			continue;
+
+		const Result& result = results.emplace_back(Measure(benchmark));
+		const std::string p99 = result.HasP99() ? fmt::format("{:.2f}", result.p99Ns) : std::string{ "-" };
+		fmt::print("{:<44} {:>12.2f} {:>12} {:>12.2f} {:>12.2f} {:>10}\n",
+			result.name, result.medianNs, p99, result.maxNs, result.stddevNs, result.iterations);
+
+		if (!result.counters.empty())
+		{
+			std::string line{ "    " };
+			for (const auto& [name, value] : result.counters)
+				line += fmt::format("{}: {:.1f}  ", name, value);
+			fmt::print("{}\n", line);
+		}
+		std::fflush(stdout);
+	}
+
+	if (!m_Options.jsonPath.empty())
+		WriteJson(m_Options.jsonPath, m_SuiteName, results);
+
+	int exitCode{ 0 };
+	if (!m_Options.baselinePath.empty())
+	{
+		if (m_Options.bUpdateBaseline)
+		{
+			WriteJson(m_Options.baselinePath, m_SuiteName, results);
+			fmt::print("Baseline written to {}\n", m_Options.baselinePath);
+		}
+		else if (!std::filesystem::exists(m_Options.baselinePath))
+		{
+			fmt::print("No baseline at {} (run with --update-baseline to create one)\n", m_Options.baselinePath);
+		}
+		else
+		{
+			const auto baseline = ReadBaseline(m_Options.baselinePath);
+			for (const auto& result : results)
+			{
+				auto it = std::ranges::find(baseline, result.name, &std::pair<std::string, double>::first);
+				if (it == baseline.end() || it->second <= 0.0)
+					continue;
+
+				const double change = result.medianNs / it->second - 1.0;
+				if (change > m_Options.threshold)
+				{
+					fmt::print("REGRESSION {}: {:.2f}ns -> {:.2f}ns ({:+.1f}%)\n",
+						result.name, it->second, result.medianNs, change * 100.0);
+					exitCode = 1;
+				}
+				else if (change < -m_Options.threshold)
+				{
+					fmt::print("Improved   {}: {:.2f}ns -> {:.2f}ns ({:+.1f}%)\n",
+						result.name, it->second, result.medianNs, change * 100.0);
+				}
+			}
+		}
+	}
+
+	return exitCode;
+}
+
+Result Summarize(std::string name, std::uint64_t iterations, std::vector<double> samples)
+{
+	Result result{};
+	result.name = std::move(name);
+	result.iterations = iterations;
+	if (samples.empty())
+		return result;
+
+	std::ranges::sort(samples);
+	const std::size_t count = samples.size();
+
+	result.minNs = samples.front();
+	result.maxNs = samples.back();
+	result.sampleCount = count;
+	result.medianNs = count % 2 == 1
+		? samples[count / 2]
+		: (samples[count / 2 - 1] + samples[count / 2]) / 2.0;
+
+	// Nearest-rank percentile. With fewer samples it would just be the max again
+	if (count >= kMinSamplesForP99)
+	{
+		const auto p99Rank = static_cast<std::size_t>(std::ceil(0.99 * static_cast<double>(count)));
+		result.p99Ns = samples[std::clamp<std::size_t>(p99Rank, 1, count) - 1];
+	}
+
+	result.meanNs = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(count);
+	double sumSquares{ 0.0 };
+	for (double sample : samples)
+		sumSquares += (sample - result.meanNs) * (sample - result.meanNs);
+	result.stddevNs = count > 1 ? std::sqrt(sumSquares / static_cast<double>(count - 1)) : 0.0;
+
+	return result;
+}
+
+std::string ToJson(const std::string& suiteName, const std::vector<Result>& results)
+{
+	std::string json = fmt::format("{{\n  \"suite\": \"{}\",\n  \"results\": [\n", EscapeJson(suiteName));
+	for (std::size_t i = 0; i < results.size(); ++i)
+	{
+		const Result& result = results[i];
+		json += fmt::format(
+			"    {{ \"name\": \"{}\", \"median_ns\": {:.3f}, \"p99_ns\": {}, \"max_ns\": {:.3f}, \"mean_ns\": {:.3f}, "
+			"\"stddev_ns\": {:.3f}, \"min_ns\": {:.3f}, \"iterations\": {}",
+			EscapeJson(result.name), result.medianNs,
+			result.HasP99() ? fmt::format("{:.3f}", result.p99Ns) : std::string{ "null" },
+			result.maxNs, result.meanNs, result.stddevNs, result.minNs, result.iterations);
+
+		if (!result.counters.empty())
+		{
+			json += ", \"counters\": {";
+			for (std::size_t c = 0; c < result.counters.size(); ++c)
+			{
+				json += fmt::format("{}\"{}\": {:.3f}", c == 0 ? " " : ", ",
+					result.counters[c].first, result.counters[c].second);
+			}
+			json += " }";
+		}
+		json += i + 1 < results.size() ? " },\n" : " }\n";
+	}
+	json += "  ]\n}\n";
+	return json;
+}
+
+void WriteJson(const std::string& path, const std::string& suiteName, const std::vector<Result>& results)
+{
+	const std::filesystem::path filePath{ path };
+	if (filePath.has_parent_path())
+		std::filesystem::create_directories(filePath.parent_path());
+
+	std::ofstream file{ filePath };
+	if (!file.is_open())
+		throw std::runtime_error(fmt::format("Failed to open [{}] for writing", path));
+
+	file << ToJson(suiteName, results);
+}
+
+std::vector<std::pair<std::string, double>> ReadBaseline(const std::string& path)
+{
+	std::ifstream file{ path };
+	std::stringstream stream;
+	stream << file.rdbuf();
+	const std::string json = stream.str();
+
+	/*
+	* This only has to read what ToJson writes: every result object has a
+	* "name" followed by a "median_ns".
+	*/
+	std::vector<std::pair<std::string, double>> baseline;
+	constexpr std::string_view kNameKey{ "\"name\": \"" };
+	constexpr std::string_view kMedianKey{ "\"median_ns\": " };
+
+	std::size_t pos{ 0 };
+	while ((pos = json.find(kNameKey, pos)) != std::string::npos)
+	{
+		pos += kNameKey.size();
+		std::string name;
+		while (pos < json.size() && json[pos] != '"')
+		{
+			if (json[pos] == '\\' && pos + 1 < json.size())
+				++pos;
+			name.push_back(json[pos++]);
+		}
+
+		const std::size_t medianPos = json.find(kMedianKey, pos);
+		if (medianPos == std::string::npos)
+			break;
+
+		baseline.emplace_back(std::move(name), std::strtod(json.c_str() + medianPos + kMedianKey.size(), nullptr));
+		pos = medianPos;
+	}
+
+	return baseline;
+}
+
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+* A small in-tree benchmark harness.
+* - Each benchmark is warmed up, then timed over several repetitions.
+* - Every repetition runs enough iterations to last at least --min-time-ms.
+* - Reports median, p99, max, mean, stddev and min per operation, plus hardware counters
+* (cycles, instructions, ...) per operation when perf_event_open is available.
+* - Results can be saved as JSON and compared against a stored baseline.
+*
+* Usage:
+*	int main(int argc, char** argv)
+*	{
+*		bench::Runner runner{ "my_suite", argc, argv };
+*		runner.Add("Thing::DoWork", [] { bench::DoNotOptimize(DoWork()); });
+*		return runner.Run();
+*	}
+*/
+namespace bench
+{
+	/* Keeps the compiler from optimizing away a value the benchmark computes. */
+	template <typename T>
+	inline void DoNotOptimize(const T& value)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "r,m"(value) : "memory");
+#else
+		const volatile char* p = reinterpret_cast<const volatile char*>(&value);
+		(void)*p;
+#endif
+	}
+
+	/* Forces the compiler to assume memory was read and written. */
+	inline void ClobberMemory()
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : : "memory");
+#endif
+	}
+
+	struct Options
+	{
+		int warmupRepetitions{ 2 };
+		int repetitions{ 15 };
+		int minTimeMs{ 20 };
+		int cpu{ -1 };				// -1 = pin to whichever CPU we start on
+		bool bPin{ true };
+		bool bUpdateBaseline{ false };
+		double threshold{ 0.10 };	// Allowed median slowdown before flagging a regression
+		std::string filter{};
+		std::string jsonPath{};
+		std::string baselinePath{};
+	};
+
+	/* Below this many repetitions p99 is just the slowest sample, so only max is reported. */
+	inline constexpr std::size_t kMinSamplesForP99{ 100 };
+
+	struct Result
+	{
+		std::string name{};
+		std::uint64_t iterations{ 0 };	// Per repetition
+		std::size_t sampleCount{ 0 };	// Repetitions
+		double medianNs{ 0.0 };
+		double p99Ns{ 0.0 };			// Only with kMinSamplesForP99 or more repetitions
+		double maxNs{ 0.0 };
+		double meanNs{ 0.0 };
+		double stddevNs{ 0.0 };
+		double minNs{ 0.0 };
+		// Hardware counters, already divided by the number of operations
+		std::vector<std::pair<std::string, double>> counters{};
+
+		bool HasP99() const { return sampleCount >= kMinSamplesForP99; }
+	};
+
+	class Runner
+	{
+	public:
+		Runner(std::string suiteName, int argc, char** argv);
+
+		/*
+		* Registers a benchmark. The callable is one operation; the harness
+		* calls it in a tight loop so it gets inlined into the timed code.
+		*/
+		template <typename Func>
+		void Add(std::string name, Func func)
+		{
+			AddBatch(std::move(name),
+				[func](std::uint64_t iterations) mutable
+				{
+					for (std::uint64_t i = 0; i < iterations; ++i)
+						func();
+				});
+		}
+
+		/*
+		* Registers a benchmark that runs the given number of operations itself.
+		* Useful when one call processes a whole batch.
+		*/
+		void AddBatch(std::string name, std::function<void(std::uint64_t)> batch);
+
+		/* Runs every benchmark. Returns a process exit code (1 on regression). */
+		int Run();
+
+		const Options& GetOptions() const { return m_Options; }
+
+	private:
+		struct Benchmark
+		{
+			std::string name;
+			std::function<void(std::uint64_t)> batch;
+		};
+
+		Result Measure(const Benchmark& benchmark);
+
+		std::string m_SuiteName;
+		Options m_Options;
+		std::vector<Benchmark> m_Benchmarks;
+	};
+
+	/* Statistics over per-operation samples in nanoseconds. */
+	Result Summarize(std::string name, std::uint64_t iterations, std::vector<double> samples);
+
+	std::string ToJson(const std::string& suiteName, const std::vector<Result>& results);
+	void WriteJson(const std::string& path, const std::string& suiteName, const std::vector<Result>& results);
+
+	/* Reads the benchmark name -> median ns pairs written by WriteJson. */
+	std::vector<std::pair<std::string, double>> ReadBaseline(const std::string& path);
+}
@@ -0,0 +1,132 @@
+#include "bench_harness.hpp"
+#include "Utilities/log_format.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include <fmt/format.h>
+
+namespace
+{
+	/* Integers of every length, so neither side gets to predict the digit count. */
+	std::array<std::int64_t, 1024> MakeValues()
+	{
+		std::array<std::int64_t, 1024> values{};
+		std::uint64_t state{ 0x9E3779B97F4A7C15 };
+		for (std::size_t i = 0; i < values.size(); ++i)
+		{
+			state ^= state << 13;
+			state ^= state >> 7;
+			state ^= state << 17;
+			values[i] = static_cast<std::int64_t>(state >> (i % 64));
+		}
+		return values;
+	}
+
+	constexpr std::string_view kMessage{
+		"Player Jadeite joined the session from 192.168.0.42 with 3 party members, "
+		"inventory synced, quest log restored, 17 achievements pending review" };
+}
+
+int main(int argc, char** argv)
+{
+	bench::Runner runner{ "log_format", argc, argv };
+	const std::array<std::int64_t, 1024> values = MakeValues();
+
+	// A typical line: text, two integers, more text
+	runner.AddBatch("fmt::format (line)",
+		[&values](std::uint64_t iterations)
+		{
+			for (std::uint64_t i = 0; i < iterations; ++i)
+			{
+				std::string line = fmt::format("Spawned {} goblins in {} ms", values[i % 1024], values[(i + 1) % 1024]);
+				bench::DoNotOptimize(line);
+			}
+		});
+
+	runner.AddBatch("fmt::format_to memory_buffer (line)",
+		[&values](std::uint64_t iterations)
+		{
+			fmt::memory_buffer line;
+			for (std::uint64_t i = 0; i < iterations; ++i)
+			{
+				line.clear();
+				fmt::format_to(std::back_inserter(line), "Spawned {} goblins in {} ms", values[i % 1024], values[(i + 1) % 1024]);
+				bench::DoNotOptimize(line);
+			}
+		});
+
+	runner.AddBatch("fmt::format_to memory_buffer (integer)",
+		[&values](std::uint64_t iterations)
+		{
+			fmt::memory_buffer text;
+			for (std::uint64_t i = 0; i < iterations; ++i)
+			{
+				text.clear();
+				fmt::format_to(std::back_inserter(text), "{}", values[i % 1024]);
+				bench::DoNotOptimize(text);
+			}
+		});
+
+	runner.AddBatch("fmt::format_to memory_buffer (message, no escaping)",
+		[](std::uint64_t iterations)
+		{
+			fmt::memory_buffer text;
+			for (std::uint64_t i = 0; i < iterations; ++i)
+			{
+				text.clear();
+				fmt::format_to(std::back_inserter(text), "{}", kMessage);
+				bench::DoNotOptimize(text);
+			}
+		});
+
+	// The same three jobs through utils::, once per kernel this CPU can run
+	for (int level = 0; level <= static_cast<int>(utils::DetectSimdLevel()); ++level)
+	{
+		const auto simdLevel = static_cast<utils::SimdLevel>(level);
+		const std::string suffix = fmt::format(" [{}]", utils::ToString(simdLevel));
+
+		runner.AddBatch("utils::AppendFormatted (line)" + suffix,
+			[&values, simdLevel](std::uint64_t iterations)
+			{
+				utils::SetSimdLevel(simdLevel);
+				fmt::memory_buffer line;
+				for (std::uint64_t i = 0; i < iterations; ++i)
+				{
+					line.clear();
+					utils::AppendFormatted(line, "Spawned {} goblins in {} ms", values[i % 1024], values[(i + 1) % 1024]);
+					bench::DoNotOptimize(line);
+				}
+			});
+
+		runner.AddBatch("utils::AppendInteger (integer)" + suffix,
+			[&values, simdLevel](std::uint64_t iterations)
+			{
+				utils::SetSimdLevel(simdLevel);
+				fmt::memory_buffer text;
+				for (std::uint64_t i = 0; i < iterations; ++i)
+				{
+					text.clear();
+					utils::AppendInteger(text, values[i % 1024]);
+					bench::DoNotOptimize(text);
+				}
+			});
+
+		runner.AddBatch("utils::AppendEscaped (message)" + suffix,
+			[simdLevel](std::uint64_t iterations)
+			{
+				utils::SetSimdLevel(simdLevel);
+				fmt::memory_buffer text;
+				for (std::uint64_t i = 0; i < iterations; ++i)
+				{
+					text.clear();
+					utils::AppendEscaped(text, kMessage);
+					bench::DoNotOptimize(text);
+				}
+			});
+	}
+
+	return runner.Run();
+}
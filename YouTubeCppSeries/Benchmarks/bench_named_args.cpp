@@ -0,0 +1,135 @@
+#include "bench_harness.hpp"
+#include "_2_NamedArgsAndMethodChaining/NamedArgsAndMethodChaining.hpp"
+#include "_2_NamedArgsAndMethodChaining/character_index.hpp"
+#include "_2_NamedArgsAndMethodChaining/character_serialization.hpp"
+#include "_2_NamedArgsAndMethodChaining/character_spawn_pipeline.hpp"
+#include "Utilities/thread_pool.hpp"
+
+#include <algorithm>
+#include <span>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+	bench::Runner runner{ "named_args", argc, argv };
+
+	runner.Add("CharacterBuilder::build",
+		[]
+		{
+			Character hero = CharacterBuilder().name("Jadeite").health(450).mana(12).level(7).build();
+			bench::DoNotOptimize(hero);
+		});
+
+	runner.Add("Character method chaining",
+		[]
+		{
+			Character hero{};
+			hero.SetName("Jadeite").SetHealth(450).SetMana(12).SetLevel(7);
+			bench::DoNotOptimize(hero);
+		});
+
+	runner.Add("CharacterParams designated init",
+		[]
+		{
+			CharacterParams params{ .sName = "Jadeite", .health = 450, .mana = 12, .level = 7 };
+			bench::DoNotOptimize(params);
+		});
+
+	/*
+	* A whole wave through the spawn pipeline, reported per character.
+	* The pool is created before Run() pins this thread, so its workers can
+	* spread over the other CPUs. The stage threads themselves start inside
+	* the batch and inherit the pin, run with --no-pin to let them spread too.
+	*/
+	constexpr int kWaveSize{ 65'536 };
+	std::vector<CharacterParams> wave;
+	wave.reserve(kWaveSize);
+	for (int i = 0; i < kWaveSize; ++i)
+		wave.push_back({ .sName = "Goblin_" + std::to_string(i), .health = 50, .mana = 10, .level = 1 + i % 100 });
+
+	utils::ThreadPool& pool = utils::DefaultThreadPool();
+	runner.AddBatch("CharacterSpawnPipeline::Run (per character)",
+		[&wave, &pool](std::uint64_t iterations)
+		{
+			CharacterSpawnPipeline pipeline{ { .batchSize = 1024, .pPool = &pool } };
+			std::vector<Character> army;
+			army.reserve(kWaveSize);
+			for (std::uint64_t remaining = iterations; remaining > 0;)
+			{
+				const auto count = static_cast<std::size_t>(std::min<std::uint64_t>(remaining, kWaveSize));
+				army.clear();
+				pipeline.Run(std::span{ wave }.first(count), army);
+				remaining -= count;
+			}
+			bench::DoNotOptimize(army);
+		});
+
+	/* Binary snapshots, per character. Buffers are reused so this is encode/decode, not malloc. */
+	std::vector<Character> snapshotArmy;
+	for (int i = 0; i < 4096; ++i)
+		snapshotArmy.push_back(CharacterBuilder().name("Goblin_" + std::to_string(i)).health(50).level(1 + i % 100).build());
+
+	std::vector<std::byte> encodeBuffer;
+	runner.AddBatch("BinaryWriter<Character>::Write (per character)",
+		[&snapshotArmy, &encodeBuffer](std::uint64_t iterations)
+		{
+			for (std::uint64_t remaining = iterations; remaining > 0;)
+			{
+				const auto count = static_cast<std::size_t>(std::min<std::uint64_t>(remaining, snapshotArmy.size()));
+				encodeBuffer.clear();
+				utils::BinaryWriter<Character> writer{ encodeBuffer };
+				writer.Write(std::span<const Character>{ snapshotArmy }.first(count));
+				remaining -= count;
+			}
+			bench::DoNotOptimize(encodeBuffer);
+		});
+
+	std::vector<std::byte> snapshot;
+	utils::BinaryWriter<Character>{ snapshot }.Write(std::span<const Character>{ snapshotArmy });
+	std::vector<Character> loaded;
+	runner.AddBatch("BinaryReader<Character>::ReadAll (per character)",
+		[&snapshot, &loaded](std::uint64_t iterations)
+		{
+			const utils::BinaryReader<Character> reader{ snapshot };
+			for (std::uint64_t done = 0; done < iterations;)
+			{
+				loaded.clear();
+				done += reader.ReadAll(loaded);
+			}
+			bench::DoNotOptimize(loaded);
+		});
+
+	/* "NPCs with level 5-10 and health under 50" over a million characters, indexed vs scanned. */
+	std::vector<Character> population;
+	population.reserve(1'000'000);
+	for (int i = 0; i < 1'000'000; ++i)
+	{
+		population.push_back(CharacterBuilder().name("Villager_" + std::to_string(i))
+			.health(i * 37 % 1000).level(1 + i % 100).npc(i % 3 == 0).build());
+	}
+	CharacterIndex populationIndex;
+	populationIndex.Add(population);
+	const CharacterFilter weakNpcs{ .bIsNPC = true, .minLevel = 5, .maxLevel = 10, .maxHealth = 49 };
+
+	runner.Add("CharacterIndex::Find (1M characters)",
+		[&populationIndex, &weakNpcs]
+		{
+			std::vector<CharacterId> ids = populationIndex.Find(weakNpcs);
+			bench::DoNotOptimize(ids);
+		});
+
+	runner.Add("Linear scan (1M characters)",
+		[&population, &weakNpcs]
+		{
+			std::vector<CharacterId> ids;
+			for (CharacterId id = 0; id < population.size(); ++id)
+			{
+				if (Matches(population[id], weakNpcs))
+					ids.push_back(id);
+			}
+			bench::DoNotOptimize(ids);
+		});
+
+	return runner.Run();
+}
@@ -0,0 +1,53 @@
+#include "bench_harness.hpp"
+#include "_6_PIMPL/pimpl_classes.hpp"
+
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+	bench::Runner runner{ "pimpl", argc, argv };
+
+	// Measure the call, not a log.txt that grows by millions of lines every run
+#if defined(_WIN32)
+	pimplTests::Logger::GetInstance().SetLogFile("NUL");
+#else
+	pimplTests::Logger::GetInstance().SetLogFile("/dev/null");
+#endif
+	runner.Add("pimplTests::Logger::Log",
+		[]
+		{
+			pimplTests::Logger::GetInstance().Log("Benchmark message");
+		});
+
+	runner.Add("pimplTests::Person construct",
+		[]
+		{
+			pimplTests::Person person{ "Jadeite", 25 };
+			bench::DoNotOptimize(person);
+		});
+
+	pimplTests::Person source{ "Jadeite", 25 };
+	runner.Add("pimplTests::Person copy",
+		[&source]
+		{
+			pimplTests::Person copy{ source };
+			bench::DoNotOptimize(copy);
+		});
+
+	// IntroduceAll is measured per person
+	constexpr std::size_t kPeople{ 1024 };
+	std::vector<std::string> names(kPeople, "Jadeite");
+	std::vector<int> ages(kPeople, 25);
+	const auto people = pimplTests::Person::CreateMany(names, ages);
+	runner.AddBatch("pimplTests::Person::IntroduceAll (per person)",
+		[&people](std::uint64_t iterations)
+		{
+			for (std::uint64_t done = 0; done < iterations; done += kPeople)
+			{
+				pimplTests::Person::IntroduceAll(people);
+			}
+		});
+
+	return runner.Run();
+}
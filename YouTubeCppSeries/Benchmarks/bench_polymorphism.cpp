@@ -0,0 +1,102 @@
+#include "bench_harness.hpp"
+
+#include <memory>
+#include <random>
+#include <variant>
+#include <vector>
+
+/*
+* The episode's animals print in Speak(), which would only measure the terminal.
+* These mirror them but return a value instead, so only the dispatch is measured.
+*/
+namespace
+{
+	class Animal
+	{
+	public:
+		virtual ~Animal() = default;
+		virtual int Speak() const = 0;
+	};
+
+	class Dog : public Animal
+	{
+	public:
+		int Speak() const override { return 1; }
+	};
+
+	class Cat : public Animal
+	{
+	public:
+		int Speak() const override { return 2; }
+	};
+
+	class Doggy
+	{
+	public:
+		int Speak() const { return 1; }
+	};
+
+	class Kitty
+	{
+	public:
+		int Speak() const { return 2; }
+	};
+
+	using VarAnimal = std::variant<Doggy, Kitty>;
+
+	constexpr std::size_t kAnimals{ 1024 };
+}
+
+int main(int argc, char** argv)
+{
+	bench::Runner runner{ "polymorphism", argc, argv };
+
+	// A random mix, so the branch predictor can't learn the order
+	std::mt19937 rng{ 42 };
+	std::bernoulli_distribution coin{ 0.5 };
+	std::vector<bool> bIsDog(kAnimals);
+	for (std::size_t i = 0; i < kAnimals; ++i)
+		bIsDog[i] = coin(rng);
+
+	std::vector<std::unique_ptr<Animal>> animals;
+	std::vector<VarAnimal> varAnimals;
+	for (std::size_t i = 0; i < kAnimals; ++i)
+	{
+		if (bIsDog[i])
+		{
+			animals.push_back(std::make_unique<Dog>());
+			varAnimals.emplace_back(Doggy{});
+		}
+		else
+		{
+			animals.push_back(std::make_unique<Cat>());
+			varAnimals.emplace_back(Kitty{});
+		}
+	}
+
+	runner.AddBatch("virtual dispatch (per call)",
+		[&animals](std::uint64_t iterations)
+		{
+			int sum{ 0 };
+			for (std::uint64_t done = 0; done < iterations; done += kAnimals)
+			{
+				for (const auto& animal : animals)
+					sum += animal->Speak();
+			}
+			bench::DoNotOptimize(sum);
+		});
+
+	runner.AddBatch("std::variant + std::visit (per call)",
+		[&varAnimals](std::uint64_t iterations)
+		{
+			int sum{ 0 };
+			for (std::uint64_t done = 0; done < iterations; done += kAnimals)
+			{
+				for (const auto& animal : varAnimals)
+					sum += std::visit([](const auto& a) { return a.Speak(); }, animal);
+			}
+			bench::DoNotOptimize(sum);
+		});
+
+	return runner.Run();
+}
@@ -0,0 +1,172 @@
+#include "bench_harness.hpp"
+#include "_5_SingletonPatternAlternatives/SingletonPatternAlternatives.hpp"
+#include "Utilities/coro_runtime.hpp"
+#include "Utilities/thread_pool.hpp"
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	/*
+	* RunMonoFromThread / RunMonoCoroutine from the episode, with 1ms naps so a
+	* run fits in a benchmark. Nearly all of the time is spent waiting.
+	*/
+	constexpr int kSleeperMessages{ 5 };
+	constexpr std::chrono::milliseconds kSleeperNap{ 1 };
+
+	void RunSleeperThread(int index)
+	{
+		MonoLogger logger{};
+		for (int i = 0; i < kSleeperMessages; ++i)
+		{
+			logger.Log("Message: {} from thread {}", i, index);
+			std::this_thread::sleep_for(kSleeperNap);
+		}
+	}
+
+	utils::Task<void> RunSleeperCoroutine(utils::Scheduler& scheduler, int index)
+	{
+		MonoLogger logger{};
+		for (int i = 0; i < kSleeperMessages; ++i)
+		{
+			logger.Log("Message: {} from coroutine {}", i, index);
+			co_await scheduler.Sleep(kSleeperNap);
+		}
+		co_await logger.FlushAsync(scheduler);
+	}
+
+	void RunSleeperCoroutines(utils::Scheduler& scheduler, int count)
+	{
+		std::vector<utils::Task<void>> coroutines;
+		coroutines.reserve(static_cast<std::size_t>(count));
+		for (int i = 0; i < count; ++i)
+			coroutines.push_back(RunSleeperCoroutine(scheduler, i));
+
+		scheduler.SyncWait(utils::WhenAll(scheduler, std::move(coroutines)));
+		MonoLogger{}.Sync();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	bench::Runner runner{ "singleton_alternatives", argc, argv };
+
+	runner.Add("Logger::GetInstance",
+		[]
+		{
+			bench::DoNotOptimize(&Logger::GetInstance());
+		});
+
+	runner.Add("Logger::Log",
+		[]
+		{
+			Logger::GetInstance().Log("Benchmark message");
+		});
+
+	MonoLogger monoLogger{};
+	runner.AddBatch("MonoLogger::Log",
+		[&monoLogger](std::uint64_t iterations)
+		{
+			for (std::uint64_t i = 0; i < iterations; ++i)
+				monoLogger.Log("Benchmark message");
+
+			// Count the flush too, and keep it inside the silenced run
+			monoLogger.Sync();
+		});
+
+	/*
+	* Producers on several threads. The pool is created before Run() pins this
+	* thread, so its workers are free to spread over the other CPUs.
+	*/
+	constexpr std::uint64_t kProducers{ 4 };
+	utils::ThreadPool producers{ kProducers };
+	runner.AddBatch("MonoLogger::Log (4 threads)",
+		[&producers](std::uint64_t iterations)
+		{
+			producers.ParallelFor(std::uint64_t{ 0 }, kProducers,
+				[iterations](std::uint64_t)
+				{
+					MonoLogger logger{};
+					for (std::uint64_t i = 0; i < iterations / kProducers; ++i)
+						logger.Log("Benchmark message");
+				}, std::uint64_t{ 1 });
+
+			MonoLogger{}.Sync();
+		});
+
+	/*
+	* Many activities that mostly sleep, on 4 threads either way.
+	* - Threads: every sleeper blocks a pool thread for its whole nap, 4 nap at a time.
+	* - Coroutines: sleepers park on a timer, so all of them nap at once.
+	*/
+	constexpr int kThreadSleepers{ 64 };
+	runner.AddBatch("MonoLogger 64 sleepers, 4 threads (per run)",
+		[&producers](std::uint64_t iterations)
+		{
+			for (std::uint64_t i = 0; i < iterations; ++i)
+			{
+				producers.ParallelFor(0, kThreadSleepers, RunSleeperThread, 1);
+				MonoLogger{}.Sync();
+			}
+		});
+
+	utils::Scheduler scheduler{ kProducers };
+	for (const int sleepers : { 64, 4096 })
+	{
+		runner.AddBatch(fmt::format("MonoLogger {} sleepers, 4 coroutine workers (per run)", sleepers),
+			[&scheduler, sleepers](std::uint64_t iterations)
+			{
+				for (std::uint64_t i = 0; i < iterations; ++i)
+					RunSleeperCoroutines(scheduler, sleepers);
+			});
+	}
+
+	DILogger<> diLogger{};
+	runner.Add("DILogger<StdoutSink>::Log",
+		[&diLogger]
+		{
+			diLogger.Log("Benchmark message");
+		});
+
+	// Should measure as an empty loop
+	DILogger<NullSink> nullLogger{};
+	runner.Add("DILogger<NullSink>::Log",
+		[&nullLogger]
+		{
+			nullLogger.Log("Benchmark message");
+		});
+
+	DILogger<BufferedSink<>> bufferedLogger{};
+	runner.Add("DILogger<BufferedSink>::Log",
+		[&bufferedLogger]
+		{
+			bufferedLogger.Log("Benchmark message");
+		});
+
+	// One prefix and one Write() for the whole batch
+	constexpr std::array<std::string_view, 8> kBatch{
+		"Benchmark message", "Benchmark message", "Benchmark message", "Benchmark message",
+		"Benchmark message", "Benchmark message", "Benchmark message", "Benchmark message"
+	};
+	runner.AddBatch("DILogger<BufferedSink>::LogBatch (per message)",
+		[&bufferedLogger, &kBatch](std::uint64_t iterations)
+		{
+			for (std::uint64_t done = 0; done < iterations; done += kBatch.size())
+				bufferedLogger.LogBatch(kBatch);
+			bufferedLogger.Flush();
+		});
+
+	ServiceLocator::Provide<DILogger<>>(std::make_shared<DILogger<>>());
+	runner.Add("ServiceLocator::Get",
+		[]
+		{
+			bench::DoNotOptimize(&ServiceLocator::Get<DILogger<>>());
+		});
+
+	return runner.Run();
+}
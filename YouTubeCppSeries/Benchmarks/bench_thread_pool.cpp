@@ -0,0 +1,37 @@
+#include "bench_harness.hpp"
+#include "Utilities/thread_pool.hpp"
+
+#include <atomic>
+#include <thread>
+
+int main(int argc, char** argv)
+{
+	bench::Runner runner{ "thread_pool", argc, argv };
+
+	// Created before Run() pins the main thread, so the workers are not pinned with it
+	utils::ThreadPool pool{};
+
+	runner.Add("std::thread create + join",
+		[]
+		{
+			std::thread thread{ [] {} };
+			thread.join();
+		});
+
+	runner.Add("ThreadPool::Submit + get",
+		[&pool]
+		{
+			pool.Submit([] {}).get();
+		});
+
+	std::atomic<int> counter{ 0 };
+	runner.AddBatch("ThreadPool::ParallelFor grain 1 (per index)",
+		[&pool, &counter](std::uint64_t iterations)
+		{
+			pool.ParallelFor(std::uint64_t{ 0 }, iterations,
+				[&counter](std::uint64_t) { counter.fetch_add(1, std::memory_order_relaxed); },
+				std::uint64_t{ 1 });
+		});
+
+	return runner.Run();
+}
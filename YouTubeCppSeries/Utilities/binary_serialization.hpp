@@ -0,0 +1,472 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace utils
+{
+	/*
+	* Compile time reflection, the manual way
+	* - C++20 can't list a struct's members for us, so every serializable type
+	* specializes Reflect<T> with a constexpr tuple of Fields (name + member pointer)
+	* and a schema version.
+	* - Everything below walks that tuple at compile time, so encoding a struct is
+	* the same straight line of stores you would write by hand.
+	* - Private members work too, the class just has to befriend Reflect:
+	*		template <typename> friend struct utils::Reflect;
+	*/
+	template <typename T>
+	struct Reflect;
+
+	template <typename Owner, typename Member>
+	struct Field
+	{
+		std::string_view name;
+		Member Owner::* pMember;
+	};
+
+	template <typename T>
+	concept Reflected = requires
+	{
+		{ Reflect<T>::version } -> std::convertible_to<std::uint16_t>;
+		std::tuple_size<std::remove_cvref_t<decltype(Reflect<T>::fields)>>::value;
+	};
+
+	template <Reflected T>
+	inline constexpr std::size_t kFieldCount{ std::tuple_size_v<std::remove_cvref_t<decltype(Reflect<T>::fields)>> };
+
+	/*
+	* Wire format, everything little-endian:
+	*
+	*	Stream:	magic "CSBS" | u16 format version | u16 schema version | record...
+	*	Record:	u32 payload size | u16 field count | field...
+	*	Field:	integers and enums -> fixed width, bool -> 1 byte, string -> u32 size + bytes
+	*
+	* Schema evolution: only ever add fields at the end of the field list.
+	* - A newer reader on older data sees fewer fields, the missing ones keep their defaults.
+	* - An older reader on newer data decodes the fields it knows and skips the rest,
+	* the payload size tells it where the next record starts.
+	*/
+	inline constexpr std::uint16_t kBinaryFormatVersion{ 1 };
+	inline constexpr char kBinaryStreamMagic[4]{ 'C', 'S', 'B', 'S' };
+	inline constexpr std::size_t kStreamHeaderSize{ 8 };
+	inline constexpr std::size_t kRecordHeaderSize{ 6 };
+
+	namespace detail
+	{
+		template <typename U>
+		void StoreLittle(std::byte* p, U value) noexcept
+		{
+			static_assert(std::is_unsigned_v<U>);
+			if constexpr (std::endian::native == std::endian::little)
+			{
+				std::memcpy(p, &value, sizeof(U));
+			}
+			else
+			{
+				for (std::size_t i = 0; i < sizeof(U); ++i)
+					p[i] = static_cast<std::byte>(value >> (8 * i));
+			}
+		}
+
+		template <typename U>
+		U LoadLittle(const std::byte* p) noexcept
+		{
+			static_assert(std::is_unsigned_v<U>);
+			U value{};
+			if constexpr (std::endian::native == std::endian::little)
+			{
+				std::memcpy(&value, p, sizeof(U));
+			}
+			else
+			{
+				for (std::size_t i = 0; i < sizeof(U); ++i)
+					value |= static_cast<U>(std::to_integer<U>(p[i]) << (8 * i));
+			}
+			return value;
+		}
+
+		/* How one member type goes on the wire. View is what a zero-copy reader hands out. */
+		template <typename M>
+		struct FieldCodec;
+
+		template <>
+		struct FieldCodec<bool>
+		{
+			using View = bool;
+
+			static std::size_t Size(bool) noexcept { return 1; }
+			static std::byte* Write(std::byte* p, bool value) noexcept
+			{
+				*p = static_cast<std::byte>(value ? 1 : 0);
+				return p + 1;
+			}
+			static View Read(const std::byte* p) noexcept { return *p != std::byte{ 0 }; }
+			static std::size_t Skip(const std::byte*, std::size_t available) noexcept
+			{
+				return available >= 1 ? 1 : 0;
+			}
+			static void Assign(bool& member, View value) noexcept { member = value; }
+		};
+
+		template <typename M>
+			requires (std::is_integral_v<M> || std::is_enum_v<M>) && (!std::is_same_v<M, bool>)
+		struct FieldCodec<M>
+		{
+			using View = M;
+			using Integer = typename std::conditional_t<std::is_enum_v<M>, std::underlying_type<M>, std::type_identity<M>>::type;
+			using Wire = std::make_unsigned_t<Integer>;
+
+			static std::size_t Size(M) noexcept { return sizeof(Wire); }
+			static std::byte* Write(std::byte* p, M value) noexcept
+			{
+				StoreLittle(p, static_cast<Wire>(value));
+				return p + sizeof(Wire);
+			}
+			static View Read(const std::byte* p) noexcept { return static_cast<M>(LoadLittle<Wire>(p)); }
+			static std::size_t Skip(const std::byte*, std::size_t available) noexcept
+			{
+				return available >= sizeof(Wire) ? sizeof(Wire) : 0;
+			}
+			static void Assign(M& member, View value) noexcept { member = value; }
+		};
+
+		template <>
+		struct FieldCodec<std::string>
+		{
+			using View = std::string_view;
+
+			static std::size_t Size(const std::string& value)
+			{
+				if (value.size() > std::numeric_limits<std::uint32_t>::max())
+					throw std::length_error("String too long to serialize");
+				return sizeof(std::uint32_t) + value.size();
+			}
+			static std::byte* Write(std::byte* p, const std::string& value) noexcept
+			{
+				StoreLittle(p, static_cast<std::uint32_t>(value.size()));
+				if (!value.empty())
+					std::memcpy(p + sizeof(std::uint32_t), value.data(), value.size());
+				return p + sizeof(std::uint32_t) + value.size();
+			}
+			static View Read(const std::byte* p) noexcept
+			{
+				return { reinterpret_cast<const char*>(p + sizeof(std::uint32_t)), LoadLittle<std::uint32_t>(p) };
+			}
+			/* 0 when it doesn't fit in 'available' bytes. */
+			static std::size_t Skip(const std::byte* p, std::size_t available) noexcept
+			{
+				if (available < sizeof(std::uint32_t))
+					return 0;
+				const std::size_t size = sizeof(std::uint32_t) + LoadLittle<std::uint32_t>(p);
+				return size <= available ? size : 0;
+			}
+			static void Assign(std::string& member, View value) { member.assign(value); }
+		};
+
+		template <typename FieldT>
+		struct FieldTraits;
+
+		template <typename Owner, typename Member>
+		struct FieldTraits<Field<Owner, Member>>
+		{
+			using Codec = FieldCodec<Member>;
+		};
+
+		template <Reflected T, std::size_t I>
+		using CodecAt = typename FieldTraits<std::remove_cvref_t<
+			decltype(std::get<I>(Reflect<T>::fields))>>::Codec;
+
+		template <Reflected T, typename Func>
+		constexpr void ForEachField(Func&& func)
+		{
+			[&]<std::size_t... I>(std::index_sequence<I...>)
+			{
+				(func(std::integral_constant<std::size_t, I>{}), ...);
+			}(std::make_index_sequence<kFieldCount<T>>{});
+		}
+
+		/* Size of the record starting at p, or throws if it doesn't fit or its known fields run past it. */
+		template <Reflected T>
+		std::size_t ValidateRecord(const std::byte* p, std::size_t available)
+		{
+			if (available < kRecordHeaderSize)
+				throw std::runtime_error("Truncated record header");
+
+			const std::size_t payloadSize = LoadLittle<std::uint32_t>(p);
+			if (payloadSize < kRecordHeaderSize - sizeof(std::uint32_t)
+				|| payloadSize > available - sizeof(std::uint32_t))
+			{
+				throw std::runtime_error("Record size out of bounds");
+			}
+
+			const std::size_t fieldCount = LoadLittle<std::uint16_t>(p + sizeof(std::uint32_t));
+			const std::byte* pField = p + kRecordHeaderSize;
+			std::size_t remaining = payloadSize - (kRecordHeaderSize - sizeof(std::uint32_t));
+
+			ForEachField<T>([&](auto index)
+				{
+					if (index >= fieldCount)
+						return;
+					const std::size_t size = CodecAt<T, index>::Skip(pField, remaining);
+					if (size == 0)
+						throw std::runtime_error("Field runs past the end of its record");
+					pField += size;
+					remaining -= size;
+				});
+
+			return sizeof(std::uint32_t) + payloadSize;
+		}
+	}
+
+	/* Bytes one record of 'value' takes, header included. */
+	template <Reflected T>
+	std::size_t EncodedSize(const T& value)
+	{
+		std::size_t size{ kRecordHeaderSize };
+		detail::ForEachField<T>([&](auto index)
+			{
+				size += detail::CodecAt<T, index>::Size(value.*std::get<index>(Reflect<T>::fields).pMember);
+			});
+		return size;
+	}
+
+	/* Writes one record at p (which must have EncodedSize(value) bytes) and returns the end. */
+	template <Reflected T>
+	std::byte* EncodeRecord(std::byte* p, const T& value) noexcept
+	{
+		std::byte* pRecord = p;
+		p += kRecordHeaderSize;
+		detail::ForEachField<T>([&](auto index)
+			{
+				p = detail::CodecAt<T, index>::Write(p, value.*std::get<index>(Reflect<T>::fields).pMember);
+			});
+
+		detail::StoreLittle(pRecord, static_cast<std::uint32_t>(p - pRecord - sizeof(std::uint32_t)));
+		detail::StoreLittle(pRecord + sizeof(std::uint32_t), static_cast<std::uint16_t>(kFieldCount<T>));
+		return p;
+	}
+
+	/*
+	* BinaryWriter
+	* - Appends a stream of T records to a byte vector, header first.
+	* - Write(span) sizes the whole batch first and grows the vector once, so
+	* bulk encoding is one allocation and a run of memcpys.
+	*/
+	template <Reflected T>
+	class BinaryWriter
+	{
+	public:
+		explicit BinaryWriter(std::vector<std::byte>& out)
+			: m_Out{ out }
+		{
+			const std::size_t start = m_Out.size();
+			m_Out.resize(start + kStreamHeaderSize);
+			std::byte* p = m_Out.data() + start;
+			std::memcpy(p, kBinaryStreamMagic, sizeof(kBinaryStreamMagic));
+			detail::StoreLittle(p + 4, kBinaryFormatVersion);
+			detail::StoreLittle(p + 6, static_cast<std::uint16_t>(Reflect<T>::version));
+		}
+
+		void Write(const T& value)
+		{
+			const std::size_t start = m_Out.size();
+			m_Out.resize(start + EncodedSize(value));
+			EncodeRecord(m_Out.data() + start, value);
+			++m_Count;
+		}
+
+		void Write(std::span<const T> values)
+		{
+			std::size_t size{ 0 };
+			for (const T& value : values)
+				size += EncodedSize(value);
+
+			const std::size_t start = m_Out.size();
+			m_Out.resize(start + size);
+			std::byte* p = m_Out.data() + start;
+			for (const T& value : values)
+				p = EncodeRecord(p, value);
+			m_Count += values.size();
+		}
+
+		std::size_t Count() const { return m_Count; }
+
+	private:
+		std::vector<std::byte>& m_Out;
+		std::size_t m_Count{ 0 };
+	};
+
+	/*
+	* RecordView
+	* - Reads fields straight out of the encoded bytes. Strings come back as
+	* string_views into the buffer, nothing is copied or allocated.
+	* - Fields the record doesn't have (written by an older schema) read as
+	* the value a default constructed T has.
+	* - Only valid while the buffer it points into is alive.
+	*/
+	template <Reflected T>
+	class RecordView
+	{
+	public:
+		RecordView(const std::byte* pRecord, std::size_t size)
+			: m_pRecord{ pRecord }
+			, m_Size{ size }
+			, m_FieldCount{ detail::LoadLittle<std::uint16_t>(pRecord + sizeof(std::uint32_t)) }
+		{
+		}
+
+		/* Index of a field by name, at compile time: view.Get<RecordView<T>::IndexOf("level")>() */
+		static constexpr std::size_t IndexOf(std::string_view name)
+		{
+			std::size_t found{ kFieldCount<T> };
+			detail::ForEachField<T>([&](auto index)
+				{
+					if (std::get<index>(Reflect<T>::fields).name == name)
+						found = index;
+				});
+			return found;
+		}
+
+		template <std::size_t I>
+		typename detail::CodecAt<T, I>::View Get() const
+		{
+			static_assert(I < kFieldCount<T>, "No such field");
+			if (I >= m_FieldCount)
+			{
+				static const T defaults{};
+				return defaults.*std::get<I>(Reflect<T>::fields).pMember;
+			}
+
+			// Fields are variable sized, walk up to the one we want
+			const std::byte* p = m_pRecord + kRecordHeaderSize;
+			[&]<std::size_t... J>(std::index_sequence<J...>)
+			{
+				((p += detail::CodecAt<T, J>::Skip(p, std::numeric_limits<std::size_t>::max())), ...);
+			}(std::make_index_sequence<I>{});
+			return detail::CodecAt<T, I>::Read(p);
+		}
+
+		/* Copies every field this record has into 'out', leaving the others alone. */
+		void DecodeInto(T& out) const
+		{
+			const std::byte* p = m_pRecord + kRecordHeaderSize;
+			detail::ForEachField<T>([&](auto index)
+				{
+					using Codec = detail::CodecAt<T, index>;
+					if (index >= m_FieldCount)
+						return;
+					Codec::Assign(out.*std::get<index>(Reflect<T>::fields).pMember, Codec::Read(p));
+					p += Codec::Skip(p, std::numeric_limits<std::size_t>::max());
+				});
+		}
+
+		T Decode() const
+		{
+			T value{};
+			DecodeInto(value);
+			return value;
+		}
+
+		std::size_t FieldCount() const { return m_FieldCount; }
+		std::size_t Size() const { return m_Size; }
+
+	private:
+		const std::byte* m_pRecord;
+		std::size_t m_Size;
+		std::size_t m_FieldCount;
+	};
+
+	/*
+	* BinaryReader
+	* - Checks the stream header, then walks the records without copying them.
+	* - Every record is bounds checked once as the iterator reaches it, a
+	* truncated or corrupt stream throws std::runtime_error instead of reading past the end.
+	*/
+	template <Reflected T>
+	class BinaryReader
+	{
+	public:
+		explicit BinaryReader(std::span<const std::byte> bytes)
+		{
+			if (bytes.size() < kStreamHeaderSize
+				|| std::memcmp(bytes.data(), kBinaryStreamMagic, sizeof(kBinaryStreamMagic)) != 0)
+			{
+				throw std::runtime_error("Not a binary character stream");
+			}
+
+			const std::uint16_t formatVersion = detail::LoadLittle<std::uint16_t>(bytes.data() + 4);
+			if (formatVersion != kBinaryFormatVersion)
+				throw std::runtime_error("Unsupported binary stream format version");
+
+			m_SchemaVersion = detail::LoadLittle<std::uint16_t>(bytes.data() + 6);
+			m_Records = bytes.subspan(kStreamHeaderSize);
+		}
+
+		class Iterator
+		{
+		public:
+			using value_type = RecordView<T>;
+			using difference_type = std::ptrdiff_t;
+
+			Iterator() = default;
+			explicit Iterator(std::span<const std::byte> remaining) : m_Remaining{ remaining } { Validate(); }
+
+			RecordView<T> operator*() const { return { m_Remaining.data(), m_RecordSize }; }
+
+			Iterator& operator++()
+			{
+				m_Remaining = m_Remaining.subspan(m_RecordSize);
+				Validate();
+				return *this;
+			}
+			Iterator operator++(int) { Iterator old{ *this }; ++*this; return old; }
+
+			bool operator==(std::default_sentinel_t) const { return m_Remaining.empty(); }
+
+		private:
+			void Validate()
+			{
+				m_RecordSize = m_Remaining.empty()
+					? 0
+					: detail::ValidateRecord<T>(m_Remaining.data(), m_Remaining.size());
+			}
+
+			std::span<const std::byte> m_Remaining{};
+			std::size_t m_RecordSize{ 0 };
+		};
+
+		Iterator begin() const { return Iterator{ m_Records }; }
+		std::default_sentinel_t end() const { return {}; }
+
+		/* Decodes every record and appends them to 'out'. Returns how many there were. */
+		std::size_t ReadAll(std::vector<T>& out) const
+		{
+			// Count first (walking the records is cheap), so 'out' grows exactly once
+			const std::size_t count = static_cast<std::size_t>(std::ranges::distance(begin(), end()));
+			out.reserve(out.size() + count);
+			for (const RecordView<T> record : *this)
+				record.DecodeInto(out.emplace_back());
+			return count;
+		}
+
+		/* The Reflect<T>::version of whoever wrote the stream. */
+		std::uint16_t SchemaVersion() const { return m_SchemaVersion; }
+
+	private:
+		std::span<const std::byte> m_Records{};
+		std::uint16_t m_SchemaVersion{ 0 };
+	};
+}
@@ -0,0 +1,214 @@
+#include "coro_runtime.hpp"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+namespace utils
+{
+Scheduler::Scheduler(std::size_t workerCount, std::size_t ioThreadCount)
+	: m_Workers{ workerCount }
+	, m_IoThreads{ std::max<std::size_t>(1, ioThreadCount) }
+	, m_TimerThread{ &Scheduler::TimerLoop, this }
+{
+}
+
+Scheduler::~Scheduler()
+{
+	// A spawned task may still be sleeping. Stopping the timers now would strand it forever
+	WaitIdle();
+
+	{
+		std::lock_guard lock{ m_TimerMutex };
+		m_bStopTimers = true;
+	}
+	m_TimerCondition.notify_one();
+	m_TimerThread.join();
+}
+
+void Scheduler::Resume(std::coroutine_handle<> handle)
+{
+	m_Workers.Post([handle] { handle.resume(); });
+}
+
+void Scheduler::AddTimer(Clock::time_point deadline, std::coroutine_handle<> handle)
+{
+	bool bNewEarliest{ false };
+	{
+		std::lock_guard lock{ m_TimerMutex };
+		bNewEarliest = m_Timers.empty() || deadline < m_Timers.top().deadline;
+		m_Timers.push({ deadline, handle });
+	}
+
+	// Only wake the timer thread when it has to wait for less time than it thought
+	if (bNewEarliest)
+		m_TimerCondition.notify_one();
+}
+
+void Scheduler::TimerLoop()
+{
+	std::unique_lock lock{ m_TimerMutex };
+	while (!m_bStopTimers)
+	{
+		if (m_Timers.empty())
+		{
+			m_TimerCondition.wait(lock, [this] { return m_bStopTimers || !m_Timers.empty(); });
+			continue;
+		}
+
+		const auto deadline = m_Timers.top().deadline;
+		if (Clock::now() < deadline)
+		{
+			m_TimerCondition.wait_until(lock, deadline);
+			continue;
+		}
+
+		// Hand every expired timer to the workers in one go
+		std::vector<std::coroutine_handle<>> expired;
+		const auto now = Clock::now();
+		while (!m_Timers.empty() && m_Timers.top().deadline <= now)
+		{
+			expired.push_back(m_Timers.top().handle);
+			m_Timers.pop();
+		}
+
+		lock.unlock();
+		for (auto handle : expired)
+			Resume(handle);
+		lock.lock();
+	}
+}
+
+Task<std::string> Scheduler::ReadFile(std::filesystem::path path)
+{
+	// This frame outlives the offloaded call, so capturing by reference is fine
+	co_return co_await Offload(
+		[&path]
+		{
+			std::ifstream file{ path, std::ios::binary };
+			if (!file.is_open())
+				throw std::runtime_error(fmt::format("Failed to open file [{}]", path.string()));
+
+			std::stringstream contents;
+			contents << file.rdbuf();
+			return contents.str();
+		});
+}
+
+Task<void> Scheduler::WriteFile(std::filesystem::path path, std::string data, bool bAppend)
+{
+	co_await Offload(
+		[&path, &data, bAppend]
+		{
+			std::ofstream file{ path, std::ios::binary | (bAppend ? std::ios::app : std::ios::trunc) };
+			if (!file.is_open())
+				throw std::runtime_error(fmt::format("Failed to open file [{}]", path.string()));
+
+			file.write(data.data(), static_cast<std::streamsize>(data.size()));
+		});
+}
+
+void Scheduler::Spawn(Task<void> task)
+{
+	{
+		std::lock_guard lock{ m_IdleMutex };
+		++m_Outstanding;
+	}
+	RunDetached(*this, std::move(task));
+}
+
+void Scheduler::WaitIdle()
+{
+	std::unique_lock lock{ m_IdleMutex };
+	m_IdleCondition.wait(lock, [this] { return m_Outstanding == 0; });
+}
+
+detail::DetachedTask Scheduler::RunDetached(Scheduler& scheduler, Task<void> task)
+{
+	co_await scheduler.Schedule();
+	{
+		// Free the task's frame before WaitIdle() can return
+		Task<void> owned{ std::move(task) };
+		try
+		{
+			co_await std::move(owned);
+		}
+		catch (const std::exception& ex)
+		{
+			fmt::print(stderr, "Spawned task failed: {}\n", ex.what());
+		}
+	}
+
+	std::lock_guard lock{ scheduler.m_IdleMutex };
+	if (--scheduler.m_Outstanding == 0)
+		scheduler.m_IdleCondition.notify_all();
+}
+
+namespace
+{
+	struct WhenAllState
+	{
+		std::atomic<std::size_t> remaining{ 0 };
+		std::coroutine_handle<> continuation{};
+		std::mutex errorMutex;
+		std::exception_ptr pError{ nullptr };
+	};
+
+	detail::DetachedTask RunWhenAllChild(Scheduler& scheduler, Task<void> task, WhenAllState& state)
+	{
+		co_await scheduler.Schedule();
+		try
+		{
+			co_await std::move(task);
+		}
+		catch (...)
+		{
+			std::lock_guard lock{ state.errorMutex };
+			if (!state.pError)
+				state.pError = std::current_exception();
+		}
+
+		// The last child to finish resumes the parent
+		if (state.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			state.continuation.resume();
+	}
+}
+
+Task<void> WhenAll(Scheduler& scheduler, std::vector<Task<void>> tasks)
+{
+	if (tasks.empty())
+		co_return;
+
+	WhenAllState state{};
+	state.remaining.store(tasks.size(), std::memory_order_relaxed);
+
+	struct Awaiter
+	{
+		bool await_ready() const noexcept { return false; }
+
+		void await_suspend(std::coroutine_handle<> handle)
+		{
+			pState->continuation = handle;
+
+			// The parent may be resumed (and its frame destroyed) by the last child
+			// before this loop ends, so don't iterate over its vector.
+			auto tasks = std::move(*pTasks);
+			for (auto& task : tasks)
+				RunWhenAllChild(*pScheduler, std::move(task), *pState);
+		}
+
+		void await_resume() const noexcept {}
+
+		Scheduler* pScheduler;
+		std::vector<Task<void>>* pTasks;
+		WhenAllState* pState;
+	};
+
+	co_await Awaiter{ &scheduler, &tasks, &state };
+
+	if (state.pError)
+		std::rethrow_exception(state.pError);
+}
+
+}
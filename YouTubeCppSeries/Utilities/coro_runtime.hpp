@@ -0,0 +1,386 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <filesystem>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+namespace utils
+{
+	template <typename T = void>
+	class Task;
+
+	namespace detail
+	{
+		struct PromiseBase
+		{
+			/*
+			* When the task finishes, jump straight to whoever awaited it
+			* (symmetric transfer, so long await chains don't grow the stack).
+			*/
+			struct FinalAwaiter
+			{
+				bool await_ready() const noexcept { return false; }
+
+				template <typename Promise>
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) const noexcept
+				{
+					return handle.promise().continuation;
+				}
+
+				void await_resume() const noexcept {}
+			};
+
+			// Tasks are lazy, nothing runs until they are awaited
+			std::suspend_always initial_suspend() const noexcept { return {}; }
+			FinalAwaiter final_suspend() const noexcept { return {}; }
+			void unhandled_exception() noexcept { pError = std::current_exception(); }
+
+			std::coroutine_handle<> continuation{ std::noop_coroutine() };
+			std::exception_ptr pError{ nullptr };
+		};
+
+		template <typename T>
+		struct Promise : PromiseBase
+		{
+			Task<T> get_return_object() noexcept;
+
+			template <typename Value>
+			void return_value(Value&& inValue) { value.emplace(std::forward<Value>(inValue)); }
+
+			T Result()
+			{
+				if (pError)
+					std::rethrow_exception(pError);
+				return std::move(*value);
+			}
+
+			std::optional<T> value{};
+		};
+
+		template <>
+		struct Promise<void> : PromiseBase
+		{
+			Task<void> get_return_object() noexcept;
+			void return_void() const noexcept {}
+
+			void Result()
+			{
+				if (pError)
+					std::rethrow_exception(pError);
+			}
+		};
+
+		/* A coroutine nobody awaits. It starts right away and frees itself when done. */
+		struct DetachedTask
+		{
+			struct promise_type
+			{
+				DetachedTask get_return_object() const noexcept { return {}; }
+				std::suspend_never initial_suspend() const noexcept { return {}; }
+				std::suspend_never final_suspend() const noexcept { return {}; }
+				void return_void() const noexcept {}
+				void unhandled_exception() const noexcept { std::terminate(); }
+			};
+		};
+	}
+
+	/*
+	* Task<T>
+	* - A lazily started coroutine that produces a T (or rethrows its exception)
+	* when it is co_awaited.
+	* - Owns its coroutine frame, like a unique_ptr.
+	*/
+	template <typename T>
+	class [[nodiscard]] Task
+	{
+	public:
+		using promise_type = detail::Promise<T>;
+		using Handle = std::coroutine_handle<promise_type>;
+
+		Task() = default;
+		explicit Task(Handle handle) noexcept : m_Handle{ handle } {}
+		Task(Task&& other) noexcept : m_Handle{ std::exchange(other.m_Handle, {}) } {}
+		Task& operator=(Task&& other) noexcept
+		{
+			if (this != &other)
+			{
+				if (m_Handle)
+					m_Handle.destroy();
+				m_Handle = std::exchange(other.m_Handle, {});
+			}
+			return *this;
+		}
+		Task(const Task&) = delete;
+		Task& operator=(const Task&) = delete;
+
+		~Task()
+		{
+			if (m_Handle)
+				m_Handle.destroy();
+		}
+
+		/* Throws std::logic_error for an empty (default constructed or moved from) Task. */
+		auto operator co_await() &&
+		{
+			if (!m_Handle)
+				throw std::logic_error{ "co_await on an empty Task" };
+
+			struct Awaiter
+			{
+				bool await_ready() const noexcept { return handle.done(); }
+
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+				{
+					handle.promise().continuation = awaiting;
+					return handle;
+				}
+
+				T await_resume() { return handle.promise().Result(); }
+
+				Handle handle;
+			};
+
+			return Awaiter{ m_Handle };
+		}
+
+	private:
+		Handle m_Handle{};
+	};
+
+	namespace detail
+	{
+		template <typename T>
+		Task<T> Promise<T>::get_return_object() noexcept
+		{
+			return Task<T>{ std::coroutine_handle<Promise<T>>::from_promise(*this) };
+		}
+
+		inline Task<void> Promise<void>::get_return_object() noexcept
+		{
+			return Task<void>{ std::coroutine_handle<Promise<void>>::from_promise(*this) };
+		}
+	}
+
+	/*
+	* Scheduler
+	* - Runs coroutines on a fixed set of worker threads (a ThreadPool).
+	* - Sleep() parks a coroutine on a timer instead of blocking its thread.
+	* - Offload() runs blocking work (file I/O, flushing a log) on a small I/O pool
+	* and resumes the coroutine on a worker when it is done.
+	*
+	* Thousands of coroutines that mostly wait can share a handful of threads.
+	*
+	* NOTE: The destructor waits for every Spawn()ed task (WaitIdle()), so nothing
+	* is left parked on a timer. Tasks started any other way (SyncWait()) have
+	* finished by the time their caller can destroy the Scheduler.
+	*/
+	class Scheduler
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		explicit Scheduler(std::size_t workerCount = 0, std::size_t ioThreadCount = 2);
+		~Scheduler();
+
+		Scheduler(const Scheduler&) = delete;
+		Scheduler& operator=(const Scheduler&) = delete;
+
+		/* co_await scheduler.Schedule(); -> continue on one of the workers */
+		auto Schedule() noexcept
+		{
+			struct Awaiter
+			{
+				bool await_ready() const noexcept { return false; }
+				void await_suspend(std::coroutine_handle<> handle) const { pScheduler->Resume(handle); }
+				void await_resume() const noexcept {}
+
+				Scheduler* pScheduler;
+			};
+
+			return Awaiter{ this };
+		}
+
+		/* co_await scheduler.Sleep(100ms); -> no thread is blocked while waiting */
+		auto Sleep(Clock::duration duration) noexcept
+		{
+			struct Awaiter
+			{
+				bool await_ready() const noexcept { return deadline <= Clock::now(); }
+				void await_suspend(std::coroutine_handle<> handle) const { pScheduler->AddTimer(deadline, handle); }
+				void await_resume() const noexcept {}
+
+				Scheduler* pScheduler;
+				Clock::time_point deadline;
+			};
+
+			return Awaiter{ this, Clock::now() + duration };
+		}
+
+		/*
+		* co_await scheduler.Offload(func); -> func() runs on an I/O thread,
+		* its result (or exception) comes back to the awaiting coroutine.
+		*/
+		template <typename Func>
+		Task<std::invoke_result_t<Func&>> Offload(Func func)
+		{
+			using Result = std::invoke_result_t<Func&>;
+			using Stored = std::conditional_t<std::is_void_v<Result>, std::monostate, Result>;
+
+			std::optional<Stored> result{};
+			std::exception_ptr pError{ nullptr };
+			auto work = [&]
+			{
+				try
+				{
+					if constexpr (std::is_void_v<Result>)
+					{
+						func();
+						result.emplace();
+					}
+					else
+					{
+						result.emplace(func());
+					}
+				}
+				catch (...)
+				{
+					pError = std::current_exception();
+				}
+			};
+
+			/*
+			* NOTE: The awaiter only holds pointers into this frame. GCC may copy
+			* awaiter temporaries bitwise, which breaks members like std::string.
+			*/
+			co_await IoAwaiter<decltype(work)>{ this, &work };
+
+			if (pError)
+				std::rethrow_exception(pError);
+			if constexpr (!std::is_void_v<Result>)
+				co_return std::move(*result);
+		}
+
+		/* Awaitable file I/O, run on the I/O threads. */
+		Task<std::string> ReadFile(std::filesystem::path path);
+		Task<void> WriteFile(std::filesystem::path path, std::string data, bool bAppend = false);
+
+		/* Start a task without waiting for it. WaitIdle() waits for all of them. */
+		void Spawn(Task<void> task);
+		void WaitIdle();
+
+		/* Run a task from a normal (non-coroutine) thread and block for its result. */
+		template <typename T>
+		T SyncWait(Task<T> task)
+		{
+			using Stored = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+			std::optional<Stored> result{};
+			std::exception_ptr pError{ nullptr };
+			// A promise rather than a latch: its shared state stays alive until both sides let go
+			std::promise<void> done{};
+			auto finished = done.get_future();
+
+			[](Scheduler& scheduler, Task<T> inner, std::optional<Stored>& out,
+				std::exception_ptr& error, std::promise<void>& signal) -> detail::DetachedTask
+			{
+				co_await scheduler.Schedule();
+				{
+					// Free the awaited frame before waking the caller, not after
+					Task<T> owned{ std::move(inner) };
+					try
+					{
+						if constexpr (std::is_void_v<T>)
+						{
+							co_await std::move(owned);
+							out.emplace();
+						}
+						else
+						{
+							out.emplace(co_await std::move(owned));
+						}
+					}
+					catch (...)
+					{
+						error = std::current_exception();
+					}
+				}
+				signal.set_value();
+			}(*this, std::move(task), result, pError, done);
+
+			finished.wait();
+			if (pError)
+				std::rethrow_exception(pError);
+			if constexpr (!std::is_void_v<T>)
+				return std::move(*result);
+		}
+
+		std::size_t WorkerCount() const { return m_Workers.Size(); }
+
+	private:
+		template <typename Work>
+		struct IoAwaiter
+		{
+			bool await_ready() const noexcept { return false; }
+
+			void await_suspend(std::coroutine_handle<> handle) const
+			{
+				pScheduler->m_IoThreads.Post(
+					[pScheduler = pScheduler, pWork = pWork, handle]
+					{
+						(*pWork)();
+						pScheduler->Resume(handle);
+					});
+			}
+
+			void await_resume() const noexcept {}
+
+			Scheduler* pScheduler;
+			Work* pWork;
+		};
+
+		void Resume(std::coroutine_handle<> handle);
+		void AddTimer(Clock::time_point deadline, std::coroutine_handle<> handle);
+		void TimerLoop();
+		static detail::DetachedTask RunDetached(Scheduler& scheduler, Task<void> task);
+
+		struct Timer
+		{
+			Clock::time_point deadline;
+			std::coroutine_handle<> handle;
+
+			// Earliest deadline on top of the priority_queue
+			bool operator<(const Timer& other) const { return deadline > other.deadline; }
+		};
+
+		// Declared before the pools so they outlive the workers that still touch them
+		std::mutex m_IdleMutex;
+		std::condition_variable m_IdleCondition;
+		std::size_t m_Outstanding{ 0 };
+
+		ThreadPool m_Workers;
+		ThreadPool m_IoThreads;
+
+		std::mutex m_TimerMutex;
+		std::condition_variable m_TimerCondition;
+		std::priority_queue<Timer> m_Timers;
+		bool m_bStopTimers{ false };
+		std::thread m_TimerThread;
+	};
+
+	/* Awaits every task, running them concurrently on the scheduler. */
+	Task<void> WhenAll(Scheduler& scheduler, std::vector<Task<void>> tasks);
+}
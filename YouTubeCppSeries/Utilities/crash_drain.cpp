@@ -0,0 +1,364 @@
+#include "crash_drain.hpp"
+#include <algorithm>
+#include <array>
+#include <csignal>
+#include <cstring>
+#include <thread>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <cerrno>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace utils
+{
+namespace
+{
+	enum SlotState : int
+	{
+		kFree,
+		kClaimed,	// Being filled in, the handler skips it
+		kActive,
+		kDraining	// The handler is writing it out, UnregisterDrainSource() waits
+	};
+
+	/* Plain atomics in a fixed array, so the handler can read them without a lock. */
+	struct DrainSlot
+	{
+		std::atomic<int> state{ kFree };
+		std::atomic<const char*> pData{ nullptr };
+		std::atomic<std::atomic<std::size_t>*> pCommitted{ nullptr };
+		std::atomic<int> fd{ -1 };
+	};
+
+	std::array<DrainSlot, kMaxDrainSources> drainSlots{};
+	std::atomic<bool> bHandlersInstalled{ false };
+	std::atomic<bool> bDraining{ false };	// Only held while DrainAll() runs
+
+	constexpr std::array kCrashSignals{ SIGSEGV, SIGABRT, SIGTERM };
+
+	/*
+	* Whatever was installed before us (ASan, a host application, ...). The crash
+	* goes on to it after the drain, SIG_DFL only if there was nothing.
+	*/
+#if defined(_WIN32)
+	using PreviousHandler = void (*)(int);
+#else
+	using PreviousHandler = struct sigaction;
+#endif
+	std::array<PreviousHandler, kCrashSignals.size()> previousHandlers{};
+
+	std::size_t SignalIndex(int signal)
+	{
+		for (std::size_t i = 0; i < kCrashSignals.size(); ++i)
+		{
+			if (kCrashSignals[i] == signal)
+				return i;
+		}
+		return 0;
+	}
+
+	/*
+	* Writes every source out and empties it, so a signal the process survives
+	* doesn't get the same lines written again by the next one.
+	* A source that got more text meanwhile isn't emptied, Append() handles that side.
+	*/
+	void DrainAll()
+	{
+		for (DrainSlot& slot : drainSlots)
+		{
+			int expected{ kActive };
+			if (!slot.state.compare_exchange_strong(expected, kDraining, std::memory_order_acquire))
+				continue;
+
+			const char* pData = slot.pData.load(std::memory_order_relaxed);
+			std::atomic<std::size_t>& committed = *slot.pCommitted.load(std::memory_order_relaxed);
+			std::size_t size = committed.load(std::memory_order_acquire);
+			if (WriteAll(slot.fd.load(std::memory_order_relaxed), pData, size))
+				committed.compare_exchange_strong(size, 0, std::memory_order_relaxed);
+			slot.state.store(kActive, std::memory_order_release);
+		}
+	}
+
+	/* One thread drains at a time. The others wait, the first may well end the process. */
+	void DrainOnce()
+	{
+		while (bDraining.exchange(true, std::memory_order_acquire))
+		{
+#if defined(_WIN32)
+			std::this_thread::yield();
+#else
+			const timespec delay{ 0, 1'000'000 };
+			nanosleep(&delay, nullptr);
+#endif
+		}
+
+		DrainAll();
+		bDraining.store(false, std::memory_order_release);
+	}
+
+#if defined(_WIN32)
+	void CrashHandler(int signal)
+	{
+		DrainOnce();
+
+		// The CRT already put SIG_DFL back before calling us
+		const PreviousHandler previous = previousHandlers[SignalIndex(signal)];
+		if (previous == nullptr || previous == SIG_ERR || previous == SIG_DFL)
+		{
+			std::raise(signal);
+			return;
+		}
+
+		// Somebody else's handler, which may well return. If it does, we stay installed
+		previous(signal);
+		std::signal(signal, &CrashHandler);
+	}
+#else
+	void CrashHandler(int signal, siginfo_t* pInfo, void* pContext)
+	{
+		DrainOnce();
+
+		const struct sigaction& previous = previousHandlers[SignalIndex(signal)];
+		const bool bRealFault = pInfo != nullptr && pInfo->si_code > 0;
+		if (bRealFault || previous.sa_handler == SIG_DFL)
+		{
+			/*
+			* Fatal: put the previous handler back and let the signal happen again. It is
+			* blocked until this handler returns, then it goes wherever it would have gone without us.
+			* - Sent signals (abort(), kill) are raised again, to SIG_DFL.
+			* - A real fault simply faults again on the same instruction, so the previous
+			* handler sees the original address and context, not a raise() of ours.
+			*/
+			sigaction(signal, &previous, nullptr);
+			if (!bRealFault)
+				raise(signal);
+			return;
+		}
+
+		/*
+		* A sent signal somebody else handles, like a host application's SIGTERM that
+		* starts a clean shutdown. Call it as if it had been delivered to them; if it
+		* returns, the process goes on and so does our handler.
+		*/
+		if ((previous.sa_flags & SA_SIGINFO) != 0)
+			previous.sa_sigaction(signal, pInfo, pContext);
+		else
+			previous.sa_handler(signal);
+	}
+#endif
+}
+
+void InstallCrashStack()
+{
+#if !defined(_WIN32)
+	struct AltStack
+	{
+		AltStack()
+		{
+			// Keep one somebody else already set up (ASan does)
+			stack_t current{};
+			if (sigaltstack(nullptr, &current) == 0 && (current.ss_flags & SS_DISABLE) == 0)
+				return;
+
+			const std::size_t size = std::max<std::size_t>(64 * 1024, static_cast<std::size_t>(SIGSTKSZ));
+			pStack = std::make_unique<char[]>(size);
+			stack_t stack{};
+			stack.ss_sp = pStack.get();
+			stack.ss_size = size;
+			if (sigaltstack(&stack, nullptr) != 0)
+				pStack.reset();
+		}
+
+		~AltStack()
+		{
+			if (!pStack)
+				return;
+			stack_t stack{};
+			stack.ss_flags = SS_DISABLE;
+			sigaltstack(&stack, nullptr);
+		}
+
+		AltStack(const AltStack&) = delete;
+		AltStack& operator=(const AltStack&) = delete;
+
+		std::unique_ptr<char[]> pStack;
+	};
+
+	thread_local AltStack stack{};
+	static_cast<void>(stack);
+#endif
+}
+
+void InstallCrashHandlers()
+{
+	InstallCrashStack();
+	if (bHandlersInstalled.exchange(true))
+		return;
+
+#if defined(_WIN32)
+	for (std::size_t i = 0; i < kCrashSignals.size(); ++i)
+		previousHandlers[i] = std::signal(kCrashSignals[i], &CrashHandler);
+#else
+	struct sigaction action {};
+	action.sa_sigaction = &CrashHandler;
+	// SA_ONSTACK: a stack overflow still drains, on the thread's InstallCrashStack() stack
+	action.sa_flags = SA_SIGINFO | SA_RESTART | SA_ONSTACK;
+
+	// None of the crash signals can interrupt a drain that is already running
+	sigemptyset(&action.sa_mask);
+	for (int signal : kCrashSignals)
+		sigaddset(&action.sa_mask, signal);
+
+	for (std::size_t i = 0; i < kCrashSignals.size(); ++i)
+	{
+		// A signal somebody chose to ignore stays ignored, it won't end the process
+		sigaction(kCrashSignals[i], nullptr, &previousHandlers[i]);
+		if (previousHandlers[i].sa_handler == SIG_IGN)
+			continue;
+		sigaction(kCrashSignals[i], &action, nullptr);
+	}
+#endif
+}
+
+int RegisterDrainSource(const char* pData, std::atomic<std::size_t>& committed, int fd)
+{
+	InstallCrashHandlers();
+
+	for (std::size_t i = 0; i < drainSlots.size(); ++i)
+	{
+		DrainSlot& slot = drainSlots[i];
+		int expected{ kFree };
+		if (!slot.state.compare_exchange_strong(expected, kClaimed, std::memory_order_acquire))
+			continue;
+
+		slot.pData.store(pData, std::memory_order_relaxed);
+		slot.pCommitted.store(&committed, std::memory_order_relaxed);
+		slot.fd.store(fd, std::memory_order_relaxed);
+		slot.state.store(kActive, std::memory_order_release);
+		return static_cast<int>(i);
+	}
+	return -1;
+}
+
+void UnregisterDrainSource(int slot)
+{
+	if (slot < 0 || static_cast<std::size_t>(slot) >= drainSlots.size())
+		return;
+
+	// A handler on another thread may be writing the buffer out right now, it has to finish first
+	std::atomic<int>& state = drainSlots[static_cast<std::size_t>(slot)].state;
+	int expected{ kActive };
+	while (!state.compare_exchange_weak(expected, kFree, std::memory_order_acq_rel, std::memory_order_relaxed))
+	{
+		expected = kActive;
+		std::this_thread::yield();
+	}
+}
+
+int OpenDrainFile(const char* path)
+{
+#if defined(_WIN32)
+	return _open(path, _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+	return open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+#endif
+}
+
+void CloseDrainFile(int fd)
+{
+	if (fd < 0)
+		return;
+#if defined(_WIN32)
+	_close(fd);
+#else
+	close(fd);
+#endif
+}
+
+bool WriteAll(int fd, const char* pData, std::size_t size)
+{
+	if (fd < 0)
+		return false;
+
+	while (size > 0)
+	{
+#if defined(_WIN32)
+		const int written = _write(fd, pData, static_cast<unsigned int>(size < 0x7FFFFFFF ? size : 0x7FFFFFFF));
+		if (written <= 0)
+			return false;
+#else
+		const ssize_t written = write(fd, pData, size);
+		if (written < 0 && errno == EINTR)
+			continue;
+		if (written <= 0)
+			return false;
+#endif
+		pData += written;
+		size -= static_cast<std::size_t>(written);
+	}
+	return true;
+}
+
+// ===================================================================================
+// DrainBuffer
+// ===================================================================================
+DrainBuffer::DrainBuffer(int fd, std::size_t capacity, bool bOwnsFd)
+	: m_pData{ std::make_unique<char[]>(capacity) }, m_Capacity{ capacity }, m_Fd{ fd }, m_bOwnsFd{ bOwnsFd }
+{
+	m_Slot = RegisterDrainSource(m_pData.get(), m_Committed, m_Fd);
+}
+
+DrainBuffer::~DrainBuffer()
+{
+	Flush();
+	UnregisterDrainSource(m_Slot);
+	if (m_bOwnsFd)
+		CloseDrainFile(m_Fd);
+}
+
+void DrainBuffer::Append(std::string_view text)
+{
+	std::size_t used = m_Committed.load(std::memory_order_relaxed);
+	if (used + text.size() > m_Capacity)
+	{
+		Flush();
+		used = 0;
+	}
+
+	// Bigger than the whole buffer, nothing to gain from copying it first
+	if (text.size() > m_Capacity)
+	{
+		WriteAll(m_Fd, text.data(), text.size());
+		return;
+	}
+
+	/*
+	* A signal the process survived may have drained and emptied the buffer since
+	* 'used' was read. The text then moves to where the buffer ends now, and tries again.
+	*/
+	std::size_t at = used;
+	std::memcpy(m_pData.get() + at, text.data(), text.size());
+	while (!m_Committed.compare_exchange_weak(used, at + text.size(), std::memory_order_release, std::memory_order_relaxed))
+	{
+		std::memmove(m_pData.get() + used, m_pData.get() + at, text.size());
+		at = used;
+	}
+}
+
+void DrainBuffer::Flush()
+{
+	const std::size_t used = m_Committed.load(std::memory_order_relaxed);
+	if (used == 0)
+		return;
+
+	WriteAll(m_Fd, m_pData.get(), used);
+	m_Committed.store(0, std::memory_order_release);
+}
+}
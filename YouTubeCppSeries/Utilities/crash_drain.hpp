@@ -0,0 +1,102 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+namespace utils
+{
+	/*
+	* Crash Drain
+	* - Buffered logging is fast because it writes rarely, which also means a crash
+	* loses everything since the last write.
+	* - A drain source is a buffer, how much of it is filled in (an atomic) and a
+	* file descriptor that was opened up front.
+	* - On SIGSEGV, SIGABRT or SIGTERM the handler write()s every source out and
+	* empties it, then the signal goes on to whatever handler was there before
+	* (ASan's, the host application's, or SIG_DFL):
+	*   - A real fault, or a signal nobody else handles, is fatal. The previous handler
+	*   is put back and the signal happens again, so the process still dies the way
+	*   it would have.
+	*   - A sent signal with a handler of its own (a host's SIGTERM shutdown) is passed
+	*   to that handler. If it returns, ours stays installed for the next one.
+	* - The handler runs on a stack of its own, so a stack overflow drains too. See
+	* InstallCrashStack().
+	* - The handler only uses async-signal-safe calls: atomics, write(), nanosleep(),
+	* sigaction() and raise().
+	* No malloc, no locks, no stdio.
+	* On Windows the same handlers go through signal() and _write().
+	*/
+
+	/* At most this many sources at once. The handler can't grow a list. */
+	inline constexpr std::size_t kMaxDrainSources{ 16 };
+
+	inline constexpr int kStdoutFd{ 1 };
+
+	/* Installs the handlers once. Registering a source does it too. */
+	void InstallCrashHandlers();
+
+	/*
+	* Gives the calling thread an alternate signal stack, kept until it exits.
+	* Installing the handlers and registering a source do it for their thread,
+	* call it from any other thread whose stack overflow should still drain.
+	* Does nothing on Windows.
+	*/
+	void InstallCrashStack();
+
+	/*
+	* 'committed' is how many bytes of 'pData' hold finished text. Store it with
+	* release after the bytes are written, the handler never reads past it.
+	* After a drain the handler sets it back to 0 (compare-exchange, so only if
+	* it didn't move meanwhile). Move it with compare-exchange too, see DrainBuffer::Append().
+	* Returns a slot to unregister with, or -1 when all slots are taken.
+	*/
+	int RegisterDrainSource(const char* pData, std::atomic<std::size_t>& committed, int fd);
+
+	/* Call before the buffer goes away. Waits for a drain that is using it on another thread. */
+	void UnregisterDrainSource(int slot);
+
+	/* Opened now, so a crash never has to open anything. Returns -1 on failure. */
+	int OpenDrainFile(const char* path);
+	void CloseDrainFile(int fd);
+
+	/* write() until everything is out or the fd fails. Async-signal-safe. */
+	bool WriteAll(int fd, const char* pData, std::size_t size);
+
+	/*
+	* DrainBuffer
+	* - A fixed size buffer in front of a file descriptor, registered as a drain
+	* source for its whole lifetime.
+	* - Append() copies and only write()s once the buffer is full.
+	* - Flush() writes first and empties after, so a crash in between can repeat
+	* a few lines but never drops them.
+	* - One writer at a time, guard it like any other buffer. It can't move, the
+	* handler knows its address.
+	*/
+	class DrainBuffer
+	{
+	public:
+		/* Closes fd on destruction when bOwnsFd is set. */
+		DrainBuffer(int fd, std::size_t capacity, bool bOwnsFd);
+		~DrainBuffer();
+
+		DrainBuffer(const DrainBuffer&) = delete;
+		DrainBuffer& operator=(const DrainBuffer&) = delete;
+
+		void Append(std::string_view text);
+		void Flush();
+
+		/* False when no drain slot was free, the buffer then works but isn't crash-safe. */
+		bool IsCrashSafe() const { return m_Slot >= 0; }
+
+	private:
+		static_assert(std::atomic<std::size_t>::is_always_lock_free, "The signal handler needs a lock-free length");
+
+		std::unique_ptr<char[]> m_pData;
+		std::size_t m_Capacity;
+		std::atomic<std::size_t> m_Committed{ 0 };
+		int m_Fd;
+		bool m_bOwnsFd;
+		int m_Slot{ -1 };
+	};
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define CPPSERIES_HAS_RDTSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CPPSERIES_HAS_RDTSC 1
+#else
+#define CPPSERIES_HAS_RDTSC 0
+#endif
+
+namespace utils
+{
+	/*
+	* CycleClock
+	* - A timestamp that is cheap enough to take on every lock/unlock or trace span.
+	* - On x86 it reads the time stamp counter (~20 cycles, no system call).
+	* Modern CPUs tick it at a constant rate, even when the core changes frequency.
+	* - Everywhere else it falls back to steady_clock in nanoseconds.
+	*
+	* Ticks are only meaningful as differences. Convert them with ToNanoseconds().
+	*/
+	class CycleClock
+	{
+	public:
+		static std::uint64_t Now() noexcept
+		{
+#if CPPSERIES_HAS_RDTSC
+			return __rdtsc();
+#else
+			return static_cast<std::uint64_t>(
+				std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+		}
+
+		/* Measured once, the first time it is needed (~10ms). */
+		static double NanosecondsPerTick()
+		{
+			static const double ratio{ Calibrate() };
+			return ratio;
+		}
+
+		static double ToNanoseconds(std::uint64_t ticks)
+		{
+			return static_cast<double>(ticks) * NanosecondsPerTick();
+		}
+
+	private:
+		static double Calibrate()
+		{
+#if CPPSERIES_HAS_RDTSC
+			using SteadyClock = std::chrono::steady_clock;
+
+			const auto startTime = SteadyClock::now();
+			const std::uint64_t startTicks = Now();
+
+			// Busy wait rather than sleep, so the measurement isn't at the scheduler's mercy
+			while (SteadyClock::now() - startTime < std::chrono::milliseconds(10))
+			{
+			}
+
+			const std::uint64_t endTicks = Now();
+			const auto elapsed = std::chrono::duration<double, std::nano>(SteadyClock::now() - startTime);
+			return elapsed.count() / static_cast<double>(endTicks - startTicks);
+#else
+			return 1.0;
+#endif
+		}
+	};
+}
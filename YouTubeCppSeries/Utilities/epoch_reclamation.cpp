@@ -0,0 +1,213 @@
+#include "epoch_reclamation.hpp"
+#include <mutex>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+
+namespace utils
+{
+namespace
+{
+	constexpr std::uint64_t kQuiescent{ UINT64_MAX };
+
+	/* Retired lists are scanned once they grow past this many nodes. */
+	constexpr std::size_t kCollectThreshold{ 64 };
+
+	/*
+	* One record per registered thread. Each record sits on its own cache line so
+	* pinning only ever writes to memory owned by the pinning thread.
+	*/
+	struct alignas(64) ThreadRecord
+	{
+		std::atomic<std::uint64_t> epoch{ kQuiescent };
+		std::atomic<bool> bInUse{ false };
+	};
+
+	struct alignas(64) GlobalEpoch
+	{
+		std::atomic<std::uint64_t> value{ 0 };
+	};
+
+	struct Retired
+	{
+		void* pNode;
+		void (*deleter)(void*);
+		std::uint64_t epoch;
+	};
+
+	GlobalEpoch gEpoch;
+	ThreadRecord gRecords[EpochDomain::kMaxThreads];
+	std::atomic<std::size_t> gHighWater{ 0 };
+	std::atomic<std::size_t> gPending{ 0 };
+
+	/*
+	* Nodes retired by threads that have already exited.
+	* Anything still here at static destruction is freed then.
+	*/
+	struct OrphanList
+	{
+		std::mutex mutex;
+		std::vector<Retired> nodes;
+
+		~OrphanList()
+		{
+			for (auto& retired : nodes)
+				retired.deleter(retired.pNode);
+		}
+	};
+
+	OrphanList gOrphans;
+
+	bool IsSafe(const Retired& retired, std::uint64_t epoch)
+	{
+		return retired.epoch + 2 <= epoch;
+	}
+
+	/* Frees every safe node in the list and keeps the rest. */
+	void FreeSafe(std::vector<Retired>& nodes, std::uint64_t epoch)
+	{
+		auto unsafe = std::partition(nodes.begin(), nodes.end(),
+			[epoch](const Retired& retired) { return !IsSafe(retired, epoch); });
+
+		for (auto it = unsafe; it != nodes.end(); ++it)
+			it->deleter(it->pNode);
+
+		gPending.fetch_sub(static_cast<std::size_t>(nodes.end() - unsafe), std::memory_order_relaxed);
+		nodes.erase(unsafe, nodes.end());
+	}
+
+	class ThreadState
+	{
+	public:
+		ThreadState()
+		{
+			for (std::size_t i = 0; i < EpochDomain::kMaxThreads; ++i)
+			{
+				bool expected{ false };
+				if (gRecords[i].bInUse.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+				{
+					m_pRecord = &gRecords[i];
+
+					std::size_t highWater = gHighWater.load(std::memory_order_relaxed);
+					while (highWater < i + 1 &&
+						!gHighWater.compare_exchange_weak(highWater, i + 1, std::memory_order_acq_rel))
+					{
+					}
+					return;
+				}
+			}
+
+			throw std::runtime_error("EpochDomain: too many threads registered");
+		}
+
+		~ThreadState()
+		{
+			m_pRecord->epoch.store(kQuiescent, std::memory_order_release);
+			m_pRecord->bInUse.store(false, std::memory_order_release);
+
+			if (!m_Retired.empty())
+			{
+				std::lock_guard lock{ gOrphans.mutex };
+				gOrphans.nodes.insert(gOrphans.nodes.end(), m_Retired.begin(), m_Retired.end());
+			}
+		}
+
+		ThreadRecord* m_pRecord{ nullptr };
+		int m_Depth{ 0 };
+		std::vector<Retired> m_Retired;
+	};
+
+	ThreadState& LocalState()
+	{
+		thread_local ThreadState state{};
+		return state;
+	}
+
+	/*
+	* The epoch may only move forward once every pinned thread has observed
+	* the current one.
+	*/
+	bool TryAdvance()
+	{
+		std::uint64_t current = gEpoch.value.load(std::memory_order_seq_cst);
+		const std::size_t count = gHighWater.load(std::memory_order_acquire);
+
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			if (!gRecords[i].bInUse.load(std::memory_order_acquire))
+				continue;
+
+			const std::uint64_t epoch = gRecords[i].epoch.load(std::memory_order_acquire);
+			if (epoch != kQuiescent && epoch != current)
+				return false;
+		}
+
+		return gEpoch.value.compare_exchange_strong(current, current + 1, std::memory_order_acq_rel);
+	}
+}
+
+EpochDomain::Guard::Guard()
+{
+	auto& state = LocalState();
+	if (state.m_Depth++ == 0)
+	{
+		state.m_pRecord->epoch.store(gEpoch.value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		// Make the pin visible before any shared node is read
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+	}
+}
+
+EpochDomain::Guard::~Guard()
+{
+	auto& state = LocalState();
+	if (--state.m_Depth == 0)
+	{
+		state.m_pRecord->epoch.store(kQuiescent, std::memory_order_release);
+	}
+}
+
+void EpochDomain::RetireRaw(void* pNode, void (*deleter)(void*))
+{
+	if (!pNode)
+		return;
+
+	auto& state = LocalState();
+	state.m_Retired.push_back({ pNode, deleter, gEpoch.value.load(std::memory_order_seq_cst) });
+	gPending.fetch_add(1, std::memory_order_relaxed);
+
+	if (state.m_Retired.size() >= kCollectThreshold)
+		Collect();
+}
+
+void EpochDomain::Collect()
+{
+	TryAdvance();
+	const std::uint64_t epoch = gEpoch.value.load(std::memory_order_acquire);
+
+	FreeSafe(LocalState().m_Retired, epoch);
+
+	// Orphans are rare, don't make readers of this path wait on them.
+	std::unique_lock lock{ gOrphans.mutex, std::try_to_lock };
+	if (lock.owns_lock())
+		FreeSafe(gOrphans.nodes, epoch);
+}
+
+void EpochDomain::DrainAll()
+{
+	FreeSafe(LocalState().m_Retired, kQuiescent);
+
+	std::lock_guard lock{ gOrphans.mutex };
+	FreeSafe(gOrphans.nodes, kQuiescent);
+}
+
+std::uint64_t EpochDomain::CurrentEpoch()
+{
+	return gEpoch.value.load(std::memory_order_acquire);
+}
+
+std::size_t EpochDomain::PendingCount()
+{
+	return gPending.load(std::memory_order_relaxed);
+}
+
+}
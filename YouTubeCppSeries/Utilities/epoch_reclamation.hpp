@@ -0,0 +1,62 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace utils
+{
+	/*
+	* Epoch Based Reclamation (EBR)
+	* - Readers enter a critical section by pinning the current global epoch with an
+	* EpochGuard. While pinned, every node they can reach is guaranteed to stay alive.
+	* - Writers unlink a node and then Retire() it instead of deleting it right away.
+	* - A retired node is only deleted once the global epoch has moved forward twice,
+	* which means no reader that could still see it is left.
+	*
+	* Unlike shared_ptr/weak_ptr, readers never touch a reference count, so traversing
+	* a read-mostly structure does not bounce cache lines between cores.
+	*/
+	class EpochDomain
+	{
+	public:
+		static constexpr std::size_t kMaxThreads{ 256 };
+
+		class Guard
+		{
+		public:
+			Guard();
+			~Guard();
+			Guard(const Guard&) = delete;
+			Guard& operator=(const Guard&) = delete;
+		};
+
+		/* Pin the current thread. Guards can be nested. */
+		static Guard Pin() { return Guard{}; }
+
+		/*
+		* Hand a node that is no longer reachable to the domain.
+		* It will be deleted once every reader that could still see it has left.
+		*/
+		template <typename T>
+		static void Retire(T* pNode)
+		{
+			RetireRaw(pNode, [](void* p) { delete static_cast<T*>(p); });
+		}
+
+		static void RetireRaw(void* pNode, void (*deleter)(void*));
+
+		/* Try to advance the epoch and free everything that is now safe to delete. */
+		static void Collect();
+
+		/*
+		* Frees every retired node regardless of epoch.
+		* Only call this when no other thread can be reading (e.g. at shutdown).
+		*/
+		static void DrainAll();
+
+		static std::uint64_t CurrentEpoch();
+		static std::size_t PendingCount();
+	};
+
+	using EpochGuard = EpochDomain::Guard;
+}
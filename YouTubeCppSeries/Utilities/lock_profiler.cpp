@@ -0,0 +1,205 @@
+#include "lock_profiler.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <memory>
+#include <unordered_map>
+
+#include <fmt/format.h>
+
+namespace utils
+{
+void LockHistogram::Merge(const LockHistogram& other) noexcept
+{
+	for (std::size_t i = 0; i < kBucketCount; ++i)
+		Bump(m_Buckets[i], other.m_Buckets[i].load(std::memory_order_relaxed));
+	Bump(m_Total, other.Total());
+	if (other.Max() > Max())
+		m_Max.store(other.Max(), std::memory_order_relaxed);
+}
+
+std::array<std::uint64_t, LockHistogram::kBucketCount> LockHistogram::Buckets() const noexcept
+{
+	std::array<std::uint64_t, kBucketCount> buckets{};
+	for (std::size_t i = 0; i < kBucketCount; ++i)
+		buckets[i] = m_Buckets[i].load(std::memory_order_relaxed);
+	return buckets;
+}
+
+void LockHistogram::Reset() noexcept
+{
+	for (auto& bucket : m_Buckets)
+		bucket.store(0, std::memory_order_relaxed);
+	m_Total.store(0, std::memory_order_relaxed);
+	m_Max.store(0, std::memory_order_relaxed);
+}
+
+namespace
+{
+	/*
+	* Every lock name ever registered, with the stats of its live mutexes and the
+	* folded-in stats of the ones already destroyed.
+	* - Created on first use and deliberately never destroyed, so mutexes inside other
+	* statics can still register, record and unregister during shutdown.
+	*/
+	struct Registry
+	{
+		struct Entry
+		{
+			std::vector<std::unique_ptr<LockStats>> live;
+			LockStats retired{};
+		};
+
+		std::mutex mutex;
+		std::unordered_map<std::string, Entry> byName;
+		std::unordered_map<const LockStats*, Entry*> owners;
+	};
+
+	Registry& GetRegistry()
+	{
+		static Registry* pRegistry{ new Registry{} };
+		return *pRegistry;
+	}
+
+	void Accumulate(LockStats& into, const LockStats& from)
+	{
+		LockHistogram::Bump(into.acquisitions, from.acquisitions.load(std::memory_order_relaxed));
+		LockHistogram::Bump(into.contentions, from.contentions.load(std::memory_order_relaxed));
+		LockHistogram::Bump(into.failedTryLocks, from.failedTryLocks.load(std::memory_order_relaxed));
+		into.waitTicks.Merge(from.waitTicks);
+		into.holdTicks.Merge(from.holdTicks);
+	}
+
+	void Clear(LockStats& stats)
+	{
+		stats.acquisitions.store(0, std::memory_order_relaxed);
+		stats.contentions.store(0, std::memory_order_relaxed);
+		stats.failedTryLocks.store(0, std::memory_order_relaxed);
+		stats.waitTicks.Reset();
+		stats.holdTicks.Reset();
+	}
+
+	/* Upper bound (in ticks) of the bucket that holds the given fraction of samples. */
+	std::uint64_t Percentile(const LockHistogram& histogram, double fraction)
+	{
+		const auto buckets = histogram.Buckets();
+		std::uint64_t count{ 0 };
+		for (const auto bucket : buckets)
+			count += bucket;
+		if (count == 0)
+			return 0;
+
+		// Nearest rank
+		const auto target = std::max<std::uint64_t>(1,
+			static_cast<std::uint64_t>(std::ceil(fraction * static_cast<double>(count))));
+		std::uint64_t seen{ 0 };
+		for (std::size_t i = 0; i < buckets.size(); ++i)
+		{
+			seen += buckets[i];
+			if (seen >= target)
+			{
+				const std::uint64_t upper = i == 0 ? 0 : (i >= 64 ? ~0ull : (1ull << i) - 1);
+				return std::min(upper, histogram.Max());
+			}
+		}
+		return histogram.Max();
+	}
+}
+
+ProfiledMutex::ProfiledMutex(const char* name)
+{
+	Registry& registry = GetRegistry();
+	std::lock_guard lock{ registry.mutex };
+
+	auto& entry = registry.byName[name];
+	m_pStats = entry.live.emplace_back(std::make_unique<LockStats>()).get();
+	registry.owners.emplace(m_pStats, &entry);
+}
+
+ProfiledMutex::~ProfiledMutex()
+{
+	Registry& registry = GetRegistry();
+	std::lock_guard lock{ registry.mutex };
+
+	// Keep what this mutex saw, but not the mutex's own slot
+	auto owner = registry.owners.find(m_pStats);
+	auto& entry = *owner->second;
+	Accumulate(entry.retired, *m_pStats);
+
+	std::erase_if(entry.live, [this](const auto& pStats) { return pStats.get() == m_pStats; });
+	registry.owners.erase(owner);
+}
+
+std::vector<LockReport> LockProfiler::Snapshot()
+{
+	Registry& registry = GetRegistry();
+	std::vector<LockReport> reports;
+	{
+		std::lock_guard lock{ registry.mutex };
+		reports.reserve(registry.byName.size());
+		for (const auto& [name, entry] : registry.byName)
+		{
+			// Live mutexes keep running while we add them up. That's fine for a report.
+			LockStats total{};
+			Accumulate(total, entry.retired);
+			for (const auto& pStats : entry.live)
+				Accumulate(total, *pStats);
+
+			LockReport report{};
+			report.name = name;
+			report.acquisitions = total.acquisitions.load(std::memory_order_relaxed);
+			report.contentions = total.contentions.load(std::memory_order_relaxed);
+			report.failedTryLocks = total.failedTryLocks.load(std::memory_order_relaxed);
+
+			report.totalWaitNs = CycleClock::ToNanoseconds(total.waitTicks.Total());
+			report.waitP50Ns = CycleClock::ToNanoseconds(Percentile(total.waitTicks, 0.50));
+			report.waitP99Ns = CycleClock::ToNanoseconds(Percentile(total.waitTicks, 0.99));
+			report.waitMaxNs = CycleClock::ToNanoseconds(total.waitTicks.Max());
+
+			report.totalHoldNs = CycleClock::ToNanoseconds(total.holdTicks.Total());
+			report.holdP50Ns = CycleClock::ToNanoseconds(Percentile(total.holdTicks, 0.50));
+			report.holdP99Ns = CycleClock::ToNanoseconds(Percentile(total.holdTicks, 0.99));
+			report.holdMaxNs = CycleClock::ToNanoseconds(total.holdTicks.Max());
+
+			reports.push_back(std::move(report));
+		}
+	}
+
+	// The lock that cost threads the most time first
+	std::sort(reports.begin(), reports.end(),
+		[](const LockReport& a, const LockReport& b) { return a.totalWaitNs > b.totalWaitNs; });
+	return reports;
+}
+
+void LockProfiler::Report(std::FILE* pOut)
+{
+	const auto reports = Snapshot();
+
+	fmt::print(pOut, "{:<24} {:>12} {:>10} {:>12} {:>12} {:>12} {:>12} {:>12} {:>12}\n",
+		"Lock", "acquired", "contended", "wait p50", "wait p99", "wait total", "hold p50", "hold p99", "hold max");
+	for (const LockReport& report : reports)
+	{
+		fmt::print(pOut, "{:<24} {:>12} {:>9.2f}% {:>10.0f}ns {:>10.0f}ns {:>10.3f}ms {:>10.0f}ns {:>10.0f}ns {:>10.0f}ns\n",
+			report.name, report.acquisitions, report.ContentionRate() * 100.0,
+			report.waitP50Ns, report.waitP99Ns, report.totalWaitNs / 1e6,
+			report.holdP50Ns, report.holdP99Ns, report.holdMaxNs);
+	}
+}
+
+/*
+* NOTE: A mutex that is held right now may still add the sample it is taking,
+* so call this between phases rather than in the middle of one.
+*/
+void LockProfiler::Reset()
+{
+	Registry& registry = GetRegistry();
+	std::lock_guard lock{ registry.mutex };
+	for (auto& [name, entry] : registry.byName)
+	{
+		Clear(entry.retired);
+		for (auto& pStats : entry.live)
+			Clear(*pStats);
+	}
+}
+
+}
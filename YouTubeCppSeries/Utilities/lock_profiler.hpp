@@ -0,0 +1,169 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "cycle_clock.hpp"
+
+namespace utils
+{
+	/*
+	* A log2 histogram of durations in CycleClock ticks.
+	* - Bucket i counts values in [2^(i-1), 2^i), so 65 buckets cover everything.
+	* - One writer at a time (whoever holds the lock being profiled), so Record() is
+	* plain relaxed loads and stores, no read-modify-write. Readers may look at any time.
+	*/
+	class LockHistogram
+	{
+	public:
+		static constexpr std::size_t kBucketCount{ 65 };
+
+		void Record(std::uint64_t ticks) noexcept
+		{
+			Bump(m_Buckets[static_cast<std::size_t>(std::bit_width(ticks))], 1);
+			Bump(m_Total, ticks);
+			if (ticks > m_Max.load(std::memory_order_relaxed))
+				m_Max.store(ticks, std::memory_order_relaxed);
+		}
+
+		/* Adds another histogram into this one. Callers must serialize this themselves. */
+		void Merge(const LockHistogram& other) noexcept;
+
+		std::array<std::uint64_t, kBucketCount> Buckets() const noexcept;
+		std::uint64_t Max() const noexcept { return m_Max.load(std::memory_order_relaxed); }
+		std::uint64_t Total() const noexcept { return m_Total.load(std::memory_order_relaxed); }
+		void Reset() noexcept;
+
+		/* counter += amount, for a counter that only one thread writes at a time. */
+		static void Bump(std::atomic<std::uint64_t>& counter, std::uint64_t amount) noexcept
+		{
+			counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+		}
+
+	private:
+		std::array<std::atomic<std::uint64_t>, kBucketCount> m_Buckets{};
+		std::atomic<std::uint64_t> m_Total{ 0 };
+		std::atomic<std::uint64_t> m_Max{ 0 };
+	};
+
+	/*
+	* Everything recorded for one mutex. Written only while that mutex is held,
+	* except failedTryLocks, which is a real atomic add.
+	*/
+	struct LockStats
+	{
+		std::atomic<std::uint64_t> acquisitions{ 0 };
+		std::atomic<std::uint64_t> contentions{ 0 };		// lock() had to wait
+		std::atomic<std::uint64_t> failedTryLocks{ 0 };
+		LockHistogram waitTicks{};
+		LockHistogram holdTicks{};
+	};
+
+	/*
+	* ProfiledMutex
+	* - A std::mutex that remembers how it was used. It is Lockable, so it drops
+	* into std::lock_guard, std::unique_lock and std::scoped_lock unchanged.
+	* - The uncontended path is one try_lock plus two clock reads. Each mutex has its
+	* own stats and only updates them while it is held, so they never add contention
+	* (or atomic read-modify-writes) of their own.
+	* - Reports add up every mutex with the same name (e.g. every shard of a sharded
+	* structure, or every instance of a class), including ones already destroyed.
+	*/
+	class ProfiledMutex
+	{
+	public:
+		explicit ProfiledMutex(const char* name);
+		~ProfiledMutex();
+
+		ProfiledMutex(const ProfiledMutex&) = delete;
+		ProfiledMutex& operator=(const ProfiledMutex&) = delete;
+
+		void lock()
+		{
+			if (!m_Mutex.try_lock())
+			{
+				const std::uint64_t waitStart = CycleClock::Now();
+				m_Mutex.lock();
+				m_AcquiredAt = CycleClock::Now();
+				LockHistogram::Bump(m_pStats->contentions, 1);
+				m_pStats->waitTicks.Record(m_AcquiredAt - waitStart);
+			}
+			else
+			{
+				m_AcquiredAt = CycleClock::Now();
+			}
+			LockHistogram::Bump(m_pStats->acquisitions, 1);
+		}
+
+		bool try_lock()
+		{
+			if (!m_Mutex.try_lock())
+			{
+				m_pStats->failedTryLocks.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			m_AcquiredAt = CycleClock::Now();
+			LockHistogram::Bump(m_pStats->acquisitions, 1);
+			return true;
+		}
+
+		void unlock()
+		{
+			m_pStats->holdTicks.Record(CycleClock::Now() - m_AcquiredAt);
+			m_Mutex.unlock();
+		}
+
+		const LockStats& Stats() const { return *m_pStats; }
+
+	private:
+		std::mutex m_Mutex;
+		LockStats* m_pStats;	// Owned by the registry, so reports can outlive the mutex
+		std::uint64_t m_AcquiredAt{ 0 };	// Only touched by the owner
+	};
+
+	/*
+	* A point in time copy of one lock's stats, in nanoseconds.
+	* The wait percentiles only cover the acquisitions that actually had to wait.
+	*/
+	struct LockReport
+	{
+		std::string name;
+		std::uint64_t acquisitions{ 0 };
+		std::uint64_t contentions{ 0 };
+		std::uint64_t failedTryLocks{ 0 };
+
+		double totalWaitNs{ 0.0 };
+		double waitP50Ns{ 0.0 };
+		double waitP99Ns{ 0.0 };
+		double waitMaxNs{ 0.0 };
+
+		double totalHoldNs{ 0.0 };
+		double holdP50Ns{ 0.0 };
+		double holdP99Ns{ 0.0 };
+		double holdMaxNs{ 0.0 };
+
+		double ContentionRate() const
+		{
+			return acquisitions ? static_cast<double>(contentions) / static_cast<double>(acquisitions) : 0.0;
+		}
+	};
+
+	/*
+	* LockProfiler
+	* - Snapshot() returns one LockReport per lock name, worst total wait first.
+	* - Report() prints them as a table.
+	* - Percentiles come from the histograms, so they are rounded up to a power of two.
+	*/
+	class LockProfiler
+	{
+	public:
+		static std::vector<LockReport> Snapshot();
+		static void Report(std::FILE* pOut = stdout);
+		static void Reset();
+	};
+}
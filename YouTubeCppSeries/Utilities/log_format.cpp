@@ -0,0 +1,383 @@
+#include "log_format.hpp"
+
+#include <atomic>
+#include <bit>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CPPSERIES_HAS_X86_SIMD 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#else
+#define CPPSERIES_HAS_X86_SIMD 0
+#endif
+
+// GCC and Clang only emit AVX2 instructions in functions marked for it, MSVC always can
+#if CPPSERIES_HAS_X86_SIMD && (defined(__GNUC__) || defined(__clang__))
+#define CPPSERIES_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define CPPSERIES_TARGET_AVX2
+#endif
+
+namespace utils
+{
+namespace
+{
+	// ===================================================================================
+	// Scalar
+	// ===================================================================================
+	constexpr char kDigitPairs[] =
+		"00010203040506070809"
+		"10111213141516171819"
+		"20212223242526272829"
+		"30313233343536373839"
+		"40414243444546474849"
+		"50515253545556575859"
+		"60616263646566676869"
+		"70717273747576777879"
+		"80818283848586878889"
+		"90919293949596979899";
+
+	/* Two digits per division, written backwards into a small buffer. */
+	char* FormatIntegerScalar(std::uint64_t value, char* pOut)
+	{
+		char digits[kMaxIntegerChars];
+		char* p = digits + kMaxIntegerChars;
+		while (value >= 100)
+		{
+			const auto pair = static_cast<std::size_t>(value % 100) * 2;
+			value /= 100;
+			*--p = kDigitPairs[pair + 1];
+			*--p = kDigitPairs[pair];
+		}
+		if (value >= 10)
+		{
+			const auto pair = static_cast<std::size_t>(value) * 2;
+			*--p = kDigitPairs[pair + 1];
+			*--p = kDigitPairs[pair];
+		}
+		else
+		{
+			*--p = static_cast<char>('0' + value);
+		}
+
+		const auto length = static_cast<std::size_t>(digits + kMaxIntegerChars - p);
+		std::memcpy(pOut, p, length);
+		return pOut + length;
+	}
+
+	bool IsControl(unsigned char c) { return c < 0x20 || c == 0x7F; }
+
+	char* EscapeControl(unsigned char c, char* pOut)
+	{
+		constexpr char kHex[] = "0123456789abcdef";
+		*pOut++ = '\\';
+		switch (c)
+		{
+		case '\n': *pOut++ = 'n'; break;
+		case '\r': *pOut++ = 'r'; break;
+		case '\t': *pOut++ = 't'; break;
+		default:
+			*pOut++ = 'x';
+			*pOut++ = kHex[c >> 4];
+			*pOut++ = kHex[c & 0xF];
+			break;
+		}
+		return pOut;
+	}
+
+	char* CopyEscapedScalar(std::string_view text, char* pOut)
+	{
+		for (const char ch : text)
+		{
+			const auto c = static_cast<unsigned char>(ch);
+			if (IsControl(c)) [[unlikely]]
+				pOut = EscapeControl(c, pOut);
+			else
+				*pOut++ = ch;
+		}
+		return pOut;
+	}
+
+#if CPPSERIES_HAS_X86_SIMD
+	// ===================================================================================
+	// SSE2 (every x86-64 CPU has it)
+	// ===================================================================================
+	/*
+	* abcdefgh (< 10^8) -> eight 16-bit lanes [a, b, c, d, e, f, g, h].
+	* Split into abcd and efgh, then divide each by 1000, 100, 10 and 1 in parallel
+	* using multiply-high by fixed-point reciprocals, and subtract 10x the lane before.
+	*/
+	__m128i EightDigitsSse2(std::uint32_t value)
+	{
+		const __m128i abcdefgh = _mm_cvtsi32_si128(static_cast<int>(value));
+
+		// abcd = abcdefgh / 10000 as (x * 0xd1b71759) >> 45
+		const __m128i abcd = _mm_srli_epi64(_mm_mul_epu32(abcdefgh, _mm_set1_epi32(static_cast<int>(0xd1b71759))), 45);
+		const __m128i efgh = _mm_sub_epi32(abcdefgh, _mm_mul_epu32(abcd, _mm_set1_epi32(10000)));
+
+		// [abcd * 4] x4, [efgh * 4] x4
+		const __m128i v1 = _mm_slli_epi64(_mm_unpacklo_epi16(abcd, efgh), 2);
+		const __m128i v2a = _mm_unpacklo_epi16(v1, v1);
+		const __m128i v2 = _mm_unpacklo_epi32(v2a, v2a);
+
+		// [a, ab, abc, abcd, e, ef, efg, efgh]
+		const __m128i divPowers = _mm_setr_epi16(8389, 5243, 13108, static_cast<short>(32768),
+			8389, 5243, 13108, static_cast<short>(32768));
+		const __m128i shiftPowers = _mm_setr_epi16(1 << 7, 1 << 11, 1 << 13, static_cast<short>(1 << 15),
+			1 << 7, 1 << 11, 1 << 13, static_cast<short>(1 << 15));
+		const __m128i v4 = _mm_mulhi_epu16(_mm_mulhi_epu16(v2, divPowers), shiftPowers);
+
+		// Subtract [0, a0, ab0, abc0, 0, e0, ef0, efg0] to leave one digit per lane
+		const __m128i v5 = _mm_mullo_epi16(v4, _mm_set1_epi16(10));
+		return _mm_sub_epi16(v4, _mm_slli_epi64(v5, 16));
+	}
+
+	/* Leading '0' bytes in the first 'count' digits, leaving at least one digit. */
+	std::size_t LeadingZeros(__m128i digits, std::size_t count)
+	{
+		const auto zeros = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(digits, _mm_set1_epi8('0'))));
+		const auto leading = static_cast<std::size_t>(std::countr_one(zeros));
+		return leading < count ? leading : count - 1;
+	}
+
+	char* FormatIntegerSse2(std::uint64_t value, char* pOut)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i ascii = _mm_set1_epi8('0');
+		alignas(16) char digits[16];
+
+		if (value < 100'000'000)
+		{
+			const __m128i text = _mm_add_epi8(_mm_packus_epi16(EightDigitsSse2(static_cast<std::uint32_t>(value)), zero), ascii);
+			_mm_store_si128(reinterpret_cast<__m128i*>(digits), text);
+			const std::size_t skip = LeadingZeros(text, 8);
+			std::memcpy(pOut, digits + skip, 8 - skip);
+			return pOut + 8 - skip;
+		}
+
+		// Anything over 16 digits: the top 1-4 digits the scalar way, then exactly 16
+		const bool bHasTop = value >= 10'000'000'000'000'000;
+		if (bHasTop)
+		{
+			pOut = FormatIntegerScalar(value / 10'000'000'000'000'000, pOut);
+			value %= 10'000'000'000'000'000;
+		}
+
+		const auto high = static_cast<std::uint32_t>(value / 100'000'000);
+		const auto low = static_cast<std::uint32_t>(value % 100'000'000);
+		const __m128i text = _mm_add_epi8(_mm_packus_epi16(EightDigitsSse2(high), EightDigitsSse2(low)), ascii);
+		_mm_store_si128(reinterpret_cast<__m128i*>(digits), text);
+		const std::size_t skip = bHasTop ? 0 : LeadingZeros(text, 16);
+
+		std::memcpy(pOut, digits + skip, 16 - skip);
+		return pOut + 16 - skip;
+	}
+
+	/*
+	* Control characters, as a byte mask: c < 0x20 || c == 0x7f.
+	* SSE2 only compares signed bytes, so flip the top bit first to compare unsigned.
+	*/
+	__m128i ControlMaskSse2(__m128i chunk)
+	{
+		const __m128i flipped = _mm_xor_si128(chunk, _mm_set1_epi8(static_cast<char>(0x80)));
+		return _mm_or_si128(
+			_mm_cmplt_epi8(flipped, _mm_set1_epi8(static_cast<char>(0x20 ^ 0x80))),
+			_mm_cmpeq_epi8(chunk, _mm_set1_epi8(0x7F)));
+	}
+
+	/*
+	* Copies a whole chunk at a time. When a chunk has a control character the clean
+	* bytes before it are already in place, so only that byte needs escaping.
+	* Writing a full chunk is always in bounds: the output has room for 4x the input left.
+	*/
+	char* CopyEscapedSse2(std::string_view text, char* pOut)
+	{
+		const char* p = text.data();
+		const char* const pEnd = p + text.size();
+		while (pEnd - p >= 16)
+		{
+			const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(pOut), chunk);
+
+			const auto mask = static_cast<unsigned>(_mm_movemask_epi8(ControlMaskSse2(chunk)));
+			if (mask == 0)
+			{
+				p += 16;
+				pOut += 16;
+				continue;
+			}
+
+			const auto clean = static_cast<std::size_t>(std::countr_zero(mask));
+			pOut = EscapeControl(static_cast<unsigned char>(p[clean]), pOut + clean);
+			p += clean + 1;
+		}
+		return CopyEscapedScalar({ p, static_cast<std::size_t>(pEnd - p) }, pOut);
+	}
+
+	// ===================================================================================
+	// AVX2
+	// ===================================================================================
+	CPPSERIES_TARGET_AVX2
+	char* CopyEscapedAvx2(std::string_view text, char* pOut)
+	{
+		const char* p = text.data();
+		const char* const pEnd = p + text.size();
+		const __m256i topBit = _mm256_set1_epi8(static_cast<char>(0x80));
+		const __m256i limit = _mm256_set1_epi8(static_cast<char>(0x20 ^ 0x80));
+		const __m256i del = _mm256_set1_epi8(0x7F);
+
+		while (pEnd - p >= 32)
+		{
+			const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(pOut), chunk);
+
+			const __m256i control = _mm256_or_si256(
+				_mm256_cmpgt_epi8(limit, _mm256_xor_si256(chunk, topBit)),
+				_mm256_cmpeq_epi8(chunk, del));
+			const auto mask = static_cast<unsigned>(_mm256_movemask_epi8(control));
+			if (mask == 0)
+			{
+				p += 32;
+				pOut += 32;
+				continue;
+			}
+
+			const auto clean = static_cast<std::size_t>(std::countr_zero(mask));
+			pOut = EscapeControl(static_cast<unsigned char>(p[clean]), pOut + clean);
+			p += clean + 1;
+		}
+		return CopyEscapedSse2({ p, static_cast<std::size_t>(pEnd - p) }, pOut);
+	}
+
+	bool CpuHasAvx2()
+	{
+#if defined(_MSC_VER) && !defined(__clang__)
+		int registers[4]{};
+		__cpuid(registers, 0);
+		if (registers[0] < 7)
+			return false;
+		__cpuid(registers, 1);
+		const bool bOsSavesYmm = (registers[2] & (1 << 27)) && (_xgetbv(0) & 0x6) == 0x6;
+		__cpuidex(registers, 7, 0);
+		return bOsSavesYmm && (registers[1] & (1 << 5));
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+#endif
+
+	// ===================================================================================
+	// Dispatch
+	// ===================================================================================
+	using FormatIntegerFn = char* (*)(std::uint64_t, char*);
+	using CopyEscapedFn = char* (*)(std::string_view, char*);
+
+	struct Kernels
+	{
+		FormatIntegerFn formatInteger;
+		CopyEscapedFn copyEscaped;
+	};
+
+	constexpr Kernels KernelsFor(SimdLevel level)
+	{
+#if CPPSERIES_HAS_X86_SIMD
+		switch (level)
+		{
+		case SimdLevel::AVX2: return { &FormatIntegerSse2, &CopyEscapedAvx2 };
+		case SimdLevel::SSE2: return { &FormatIntegerSse2, &CopyEscapedSse2 };
+		case SimdLevel::Scalar: break;
+		}
+#else
+		static_cast<void>(level);
+#endif
+		return { &FormatIntegerScalar, &CopyEscapedScalar };
+	}
+
+	/*
+	* Chosen on first use. Relaxed atomics are enough: every level produces the
+	* same output, a thread that still sees the old kernel is merely slower.
+	*/
+	struct Dispatch
+	{
+		Dispatch()
+		{
+			const Kernels kernels = KernelsFor(DetectSimdLevel());
+			formatInteger.store(kernels.formatInteger, std::memory_order_relaxed);
+			copyEscaped.store(kernels.copyEscaped, std::memory_order_relaxed);
+			level.store(DetectSimdLevel(), std::memory_order_relaxed);
+		}
+
+		std::atomic<FormatIntegerFn> formatInteger;
+		std::atomic<CopyEscapedFn> copyEscaped;
+		std::atomic<SimdLevel> level;
+	};
+
+	Dispatch& GetDispatch()
+	{
+		static Dispatch dispatch{};
+		return dispatch;
+	}
+}
+
+SimdLevel DetectSimdLevel()
+{
+#if CPPSERIES_HAS_X86_SIMD
+	static const SimdLevel detected{ CpuHasAvx2() ? SimdLevel::AVX2 : SimdLevel::SSE2 };
+	return detected;
+#else
+	return SimdLevel::Scalar;
+#endif
+}
+
+SimdLevel ActiveSimdLevel()
+{
+	return GetDispatch().level.load(std::memory_order_relaxed);
+}
+
+void SetSimdLevel(SimdLevel level)
+{
+	if (static_cast<int>(level) > static_cast<int>(DetectSimdLevel()))
+		level = DetectSimdLevel();
+
+	Dispatch& dispatch = GetDispatch();
+	const Kernels kernels = KernelsFor(level);
+	dispatch.formatInteger.store(kernels.formatInteger, std::memory_order_relaxed);
+	dispatch.copyEscaped.store(kernels.copyEscaped, std::memory_order_relaxed);
+	dispatch.level.store(level, std::memory_order_relaxed);
+}
+
+const char* ToString(SimdLevel level)
+{
+	switch (level)
+	{
+	case SimdLevel::Scalar: return "Scalar";
+	case SimdLevel::SSE2: return "SSE2";
+	case SimdLevel::AVX2: return "AVX2";
+	}
+	return "Unknown";
+}
+
+char* FormatInteger(std::uint64_t value, char* pOut)
+{
+	return GetDispatch().formatInteger.load(std::memory_order_relaxed)(value, pOut);
+}
+
+char* FormatInteger(std::int64_t value, char* pOut)
+{
+	if (value >= 0)
+		return FormatInteger(static_cast<std::uint64_t>(value), pOut);
+
+	// Negate as unsigned, -INT64_MIN doesn't fit in an int64_t
+	*pOut++ = '-';
+	return FormatInteger(0 - static_cast<std::uint64_t>(value), pOut);
+}
+
+char* CopyEscaped(std::string_view text, char* pOut)
+{
+	return GetDispatch().copyEscaped.load(std::memory_order_relaxed)(text, pOut);
+}
+
+}
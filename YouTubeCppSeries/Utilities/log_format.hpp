@@ -0,0 +1,256 @@
+#pragma once
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+
+#include <fmt/chrono.h>
+#include <fmt/format.h>
+
+namespace utils
+{
+	/*
+	* Log Formatting Kernels
+	* - FormatInteger() turns 8 digits at a time into text with SSE2 instead of
+	* dividing by 10 once per digit.
+	* - CopyEscaped() copies message text 16 (SSE2) or 32 (AVX2) bytes at a time and
+	* only slows down at control characters, which it escapes (\n, \t, \x1b, ...)
+	* so one Log() call is always exactly one line.
+	* - The best version for this CPU is picked once at startup, with a plain
+	* scalar version for everything else.
+	*/
+	enum class SimdLevel
+	{
+		Scalar,
+		SSE2,
+		AVX2
+	};
+
+	/* The best level this CPU supports. */
+	SimdLevel DetectSimdLevel();
+
+	/* What the kernels use right now. Starts as DetectSimdLevel(). */
+	SimdLevel ActiveSimdLevel();
+
+	/* Pick a level by hand (benchmarks, tests). Clamped to what the CPU supports. */
+	void SetSimdLevel(SimdLevel level);
+
+	const char* ToString(SimdLevel level);
+
+	/* The longest integer: 18446744073709551615 or -9223372036854775808 */
+	inline constexpr std::size_t kMaxIntegerChars{ 20 };
+
+	/* Writes the decimal digits at pOut (no terminator) and returns the end. */
+	char* FormatInteger(std::uint64_t value, char* pOut);
+	char* FormatInteger(std::int64_t value, char* pOut);
+
+	/* Worst case for CopyEscaped(): every byte becomes \xNN. */
+	constexpr std::size_t MaxEscapedSize(std::size_t size) { return size * 4; }
+
+	/*
+	* Copies text to pOut, which needs MaxEscapedSize(text.size()) bytes, and returns the end.
+	* \n, \r and \t become two characters, other control characters become \xNN.
+	*/
+	char* CopyEscaped(std::string_view text, char* pOut);
+
+	/* Anything with data(), size() and resize(): std::string, fmt::memory_buffer, ... */
+	template <typename Buffer>
+	concept CharBuffer = requires(Buffer & buffer, std::size_t size)
+	{
+		{ buffer.data() } -> std::convertible_to<char*>;
+		{ buffer.size() } -> std::convertible_to<std::size_t>;
+		buffer.resize(size);
+	};
+
+	namespace detail
+	{
+		template <typename T>
+		constexpr bool kIsFormattableInteger = std::is_integral_v<T>
+			&& !std::is_same_v<T, bool> && !std::is_same_v<T, char>;
+
+		template <typename T>
+		constexpr bool kIsText = std::is_convertible_v<const T&, std::string_view>;
+
+		/* Enums fmt can't print go out as their number. */
+		template <typename T>
+		constexpr bool kIsPlainEnum = std::is_enum_v<T> && !fmt::is_formattable<T>::value;
+
+		/* Everything else (double, chrono durations, ...) goes through fmt. */
+		template <typename T>
+		constexpr bool kIsFmtValue = !kIsFormattableInteger<T> && !std::is_same_v<T, bool>
+			&& !std::is_same_v<T, char> && !kIsText<T> && !kIsPlainEnum<T>;
+
+		/* What fmt made of a kIsFmtValue argument. It can't be sized without formatting it. */
+		struct FmtText
+		{
+			fmt::memory_buffer text;
+		};
+
+		/*
+		* Formats kIsFmtValue arguments up front, once, so they can be sized and copied
+		* like text. The fast paths are passed through untouched.
+		*/
+		template <typename T>
+		decltype(auto) Prepare(const T& value)
+		{
+			if constexpr (kIsFmtValue<T>)
+			{
+				static_assert(fmt::is_formattable<T>::value,
+					"Log arguments are integers, bools, chars, text, enums or anything fmt can format.");
+				FmtText formatted;
+				fmt::format_to(std::back_inserter(formatted.text), "{}", value);
+				return formatted;
+			}
+			else
+			{
+				return (value);
+			}
+		}
+
+		template <typename T>
+		std::size_t MaxFormattedSize(const T& value)
+		{
+			if constexpr (kIsFormattableInteger<T> || kIsPlainEnum<T>)
+				return kMaxIntegerChars;
+			else if constexpr (std::is_same_v<T, bool>)
+				return MaxEscapedSize(5);
+			else if constexpr (std::is_same_v<T, char>)
+				return MaxEscapedSize(1);
+			else if constexpr (kIsText<T>)
+				return MaxEscapedSize(std::string_view{ value }.size());
+			else
+			{
+				static_assert(std::is_same_v<T, FmtText>, "Pass arguments through Prepare() first");
+				return MaxEscapedSize(value.text.size());
+			}
+		}
+
+		template <typename T>
+		char* FormatValue(const T& value, char* pOut)
+		{
+			if constexpr (kIsFormattableInteger<T>)
+			{
+				if constexpr (std::is_signed_v<T>)
+					return FormatInteger(static_cast<std::int64_t>(value), pOut);
+				else
+					return FormatInteger(static_cast<std::uint64_t>(value), pOut);
+			}
+			else if constexpr (kIsPlainEnum<T>)
+			{
+				return FormatValue(static_cast<std::underlying_type_t<T>>(value), pOut);
+			}
+			else if constexpr (std::is_same_v<T, bool>)
+			{
+				return CopyEscaped(value ? "true" : "false", pOut);
+			}
+			else if constexpr (std::is_same_v<T, char>)
+			{
+				return CopyEscaped({ &value, 1 }, pOut);
+			}
+			else if constexpr (kIsText<T>)
+			{
+				return CopyEscaped(std::string_view{ value }, pOut);
+			}
+			else
+			{
+				// Escaped like any other text, a custom formatter could print a newline too
+				static_assert(std::is_same_v<T, FmtText>, "Pass arguments through Prepare() first");
+				return CopyEscaped({ value.text.data(), value.text.size() }, pOut);
+			}
+		}
+
+		constexpr std::size_t CountPlaceholders(std::string_view pattern)
+		{
+			std::size_t count{ 0 };
+			for (std::size_t at = pattern.find("{}"); at != std::string_view::npos; at = pattern.find("{}", at + 2))
+				++count;
+			return count;
+		}
+
+		// Not constexpr on purpose: reaching it in a consteval constructor is the compile error
+		inline void LogPatternPlaceholdersDoNotMatchArguments() {}
+
+		/* Copies pattern up to the next "{}", then the value. Advances pattern past the "{}". */
+		template <typename T>
+		char* FormatNext(std::string_view& pattern, const T& value, char* pOut)
+		{
+			const std::size_t placeholder = pattern.find("{}");
+			pOut = CopyEscaped(pattern.substr(0, placeholder), pOut);
+			pattern.remove_prefix(placeholder == std::string_view::npos ? pattern.size() : placeholder + 2);
+			return FormatValue(value, pOut);
+		}
+
+		template <CharBuffer Buffer, typename... Prepared>
+		void AppendPrepared(Buffer& buffer, std::string_view pattern, const Prepared&... values)
+		{
+			const std::size_t start = buffer.size();
+			buffer.resize(start + MaxEscapedSize(pattern.size()) + (std::size_t{ 0 } + ... + MaxFormattedSize(values)));
+
+			char* pOut = buffer.data() + start;
+			((pOut = FormatNext(pattern, values, pOut)), ...);
+			pOut = CopyEscaped(pattern, pOut);
+			buffer.resize(static_cast<std::size_t>(pOut - buffer.data()));
+		}
+	}
+
+	template <CharBuffer Buffer>
+	void AppendEscaped(Buffer& buffer, std::string_view text)
+	{
+		const std::size_t start = buffer.size();
+		buffer.resize(start + MaxEscapedSize(text.size()));
+		char* pEnd = CopyEscaped(text, buffer.data() + start);
+		buffer.resize(static_cast<std::size_t>(pEnd - buffer.data()));
+	}
+
+	template <CharBuffer Buffer, std::integral T>
+	void AppendInteger(Buffer& buffer, T value)
+	{
+		const std::size_t start = buffer.size();
+		buffer.resize(start + kMaxIntegerChars);
+		char* pEnd = detail::FormatValue(value, buffer.data() + start);
+		buffer.resize(static_cast<std::size_t>(pEnd - buffer.data()));
+	}
+
+	/*
+	* A pattern checked at compile time, like fmt::format_string: the number of
+	* "{}" has to match the number of arguments, or the call doesn't compile.
+	* Runtime text goes in as an argument: Log("{}", text).
+	*/
+	template <typename... Args>
+	class BasicLogPattern
+	{
+	public:
+		template <typename Text>
+			requires std::convertible_to<const Text&, std::string_view>
+		consteval BasicLogPattern(const Text& text) : m_Text{ text }
+		{
+			if (detail::CountPlaceholders(m_Text) != sizeof...(Args))
+				detail::LogPatternPlaceholdersDoNotMatchArguments();
+		}
+
+		constexpr std::string_view Get() const { return m_Text; }
+
+	private:
+		std::string_view m_Text;
+	};
+
+	/* Keeps the pattern out of template argument deduction, the arguments decide. */
+	template <typename... Args>
+	using LogPattern = BasicLogPattern<std::type_identity_t<Args>...>;
+
+	/*
+	* The logger's own tiny fmt: every "{}" in pattern is replaced by the next argument.
+	* - Integers, bools, chars and text have their own fast paths, enums fmt doesn't
+	* know are printed as numbers, anything else fmt can format goes through fmt.
+	* - Text (the pattern too) is escaped, so nothing can break the line in two.
+	* The buffer grows once, to the worst case, and shrinks back after. What goes
+	* through fmt is formatted once, before that, since its size isn't known otherwise.
+	*/
+	template <CharBuffer Buffer, typename... Args>
+	void AppendFormatted(Buffer& buffer, LogPattern<Args...> logPattern, const Args&... args)
+	{
+		detail::AppendPrepared(buffer, logPattern.Get(), detail::Prepare(args)...);
+	}
+}
@@ -0,0 +1,88 @@
+#include "singleton_registry.hpp"
+#include <cstdlib>
+
+namespace utils
+{
+namespace
+{
+	struct Entry
+	{
+		std::string name;
+		void (*destroy)();
+	};
+
+	/*
+	* Never destroyed, so it is still usable from the atexit handler
+	* no matter which other statics are already gone.
+	*/
+	struct Registry
+	{
+		std::mutex mutex;
+		std::vector<Entry> entries;
+		bool bAtExitRegistered{ false };
+		bool bShutDown{ false };
+	};
+
+	Registry& GetRegistry()
+	{
+		static Registry* pRegistry{ new Registry{} };
+		return *pRegistry;
+	}
+
+	void ShutdownAtExit()
+	{
+		SingletonRegistry::Shutdown();
+	}
+}
+
+void SingletonRegistry::Register(const char* name, void (*destroy)())
+{
+	Registry& registry = GetRegistry();
+	std::lock_guard lock{ registry.mutex };
+	registry.entries.push_back({ name, destroy });
+
+	if (!registry.bAtExitRegistered)
+	{
+		registry.bAtExitRegistered = true;
+		std::atexit(&ShutdownAtExit);
+	}
+}
+
+void SingletonRegistry::Shutdown()
+{
+	Registry& registry = GetRegistry();
+	std::unique_lock lock{ registry.mutex };
+	registry.bShutDown = true;
+
+	// Newest first. Unlock while destroying, a destructor may still Get() an older singleton.
+	while (!registry.entries.empty())
+	{
+		const Entry entry = std::move(registry.entries.back());
+		registry.entries.pop_back();
+
+		lock.unlock();
+		entry.destroy();
+		lock.lock();
+	}
+}
+
+bool SingletonRegistry::IsShutDown()
+{
+	Registry& registry = GetRegistry();
+	std::lock_guard lock{ registry.mutex };
+	return registry.bShutDown;
+}
+
+std::vector<std::string> SingletonRegistry::ConstructionOrder()
+{
+	Registry& registry = GetRegistry();
+	std::lock_guard lock{ registry.mutex };
+
+	std::vector<std::string> names;
+	names.reserve(registry.entries.size());
+	for (const Entry& entry : registry.entries)
+		names.push_back(entry.name);
+	return names;
+}
+
+}
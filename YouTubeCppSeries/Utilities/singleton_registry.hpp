@@ -0,0 +1,88 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+namespace utils
+{
+	/*
+	* SingletonRegistry
+	* - Remembers the order singletons finished constructing in.
+	* - Shutdown() destroys them in reverse order, so a singleton that used another
+	* one in its constructor (a dependency) is destroyed before it. Each one is
+	* flushed right before it is deleted.
+	* - Shutdown() runs at exit by itself, call it earlier to control exactly when
+	* teardown happens (e.g. at the end of main, while everything else is still alive).
+	*/
+	class SingletonRegistry
+	{
+	public:
+		static void Register(const char* name, void (*destroy)());
+		static void Shutdown();
+		static bool IsShutDown();
+
+		/* Type names, oldest first. Handy to check the teardown order. */
+		static std::vector<std::string> ConstructionOrder();
+	};
+
+	/*
+	* Singleton<T>
+	* - Get() is one acquire load of a pointer once T exists. On x86 that is a plain
+	* mov: no guard variable, no lock, no function-local static.
+	* - The first Get() builds T under a lock, which only the first few callers ever see.
+	* - T can keep its constructor and destructor private, as long as it is a
+	* friend of Singleton<T>.
+	* - After teardown Get() throws instead of handing out a dangling reference.
+	*/
+	template <typename T>
+	class Singleton
+	{
+	public:
+		static T& Get()
+		{
+			if (T* pInstance = instance.load(std::memory_order_acquire)) [[likely]]
+				return *pInstance;
+			return Create();
+		}
+
+		/* Nullptr before the first Get() and after teardown. */
+		static T* TryGet() noexcept { return instance.load(std::memory_order_acquire); }
+
+	private:
+		static T& Create()
+		{
+			std::lock_guard lock{ createMutex };
+			if (T* pInstance = instance.load(std::memory_order_relaxed))
+				return *pInstance;
+
+			if (bDestroyed)
+				throw std::logic_error{ std::string{ "Singleton used after teardown: " } + typeid(T).name() };
+
+			// Anything T's constructor Get()s is registered first, so it is destroyed after T
+			T* pInstance = new T();
+			instance.store(pInstance, std::memory_order_release);
+			SingletonRegistry::Register(typeid(T).name(), &Destroy);
+			return *pInstance;
+		}
+
+		static void Destroy()
+		{
+			std::lock_guard lock{ createMutex };
+			T* pInstance = instance.exchange(nullptr, std::memory_order_acq_rel);
+			bDestroyed = true;
+			if (!pInstance)
+				return;
+
+			if constexpr (requires { pInstance->Flush(); })
+				pInstance->Flush();
+			delete pInstance;
+		}
+
+		inline static std::atomic<T*> instance{ nullptr };
+		inline static std::mutex createMutex;
+		inline static bool bDestroyed{ false };	// Guarded by createMutex
+	};
+}
@@ -0,0 +1,150 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <utility>
+
+namespace utils
+{
+	/*
+	* Bounded Single Producer / Single Consumer queue
+	* - Exactly one thread pushes and exactly one thread pops, so a slot is handed over
+	* with one release store and one acquire load, no locks and no CAS loops.
+	* - Head and tail live on their own cache lines, and each side keeps a cached copy
+	* of the other side's index so it rarely has to read the shared one.
+	* - Push() blocks while the queue is full. That is the backpressure: a fast stage
+	* can never run further ahead of a slow one than the queue's capacity.
+	* - Close() marks the end of the stream, Pop() returns nullopt once it has drained.
+	*/
+	template <typename T>
+	class SpscQueue
+	{
+	public:
+		/* Capacity is rounded up to a power of two. */
+		explicit SpscQueue(std::size_t capacity)
+			: m_Capacity{ std::bit_ceil(std::max<std::size_t>(capacity, 2)) }
+			, m_Mask{ m_Capacity - 1 }
+			, m_pSlots{ std::make_unique<std::optional<T>[]>(m_Capacity) }
+		{
+		}
+
+		SpscQueue(const SpscQueue&) = delete;
+		SpscQueue& operator=(const SpscQueue&) = delete;
+
+		/* Producer only. Returns false (and leaves 'value' alone) when full. */
+		bool TryPush(T& value)
+		{
+			const std::size_t tail = m_Tail.load(std::memory_order_relaxed) & kIndexMask;
+			if (tail - m_CachedHead == m_Capacity)
+			{
+				m_CachedHead = m_Head.load(std::memory_order_acquire);
+				if (tail - m_CachedHead == m_Capacity)
+					return false;
+			}
+
+			m_pSlots[tail & m_Mask].emplace(std::move(value));
+			m_Tail.store(tail + 1, std::memory_order_release);
+			m_Tail.notify_one();
+			return true;
+		}
+
+		/* Producer only. Waits for room. */
+		void Push(T value)
+		{
+			for (int spin = 0; !TryPush(value); ++spin)
+			{
+				if (spin < kSpinLimit)
+				{
+					std::this_thread::yield();
+					continue;
+				}
+
+				// Sleep until the consumer moves the head
+				const std::size_t head = m_Head.load(std::memory_order_acquire);
+				if ((m_Tail.load(std::memory_order_relaxed) & kIndexMask) - head == m_Capacity)
+					m_Head.wait(head, std::memory_order_acquire);
+			}
+		}
+
+		/* Producer only. No more pushes after this. */
+		void Close()
+		{
+			// The flag lives in the tail itself, so a consumer waiting on the tail always sees it change
+			m_Tail.fetch_or(kClosedBit, std::memory_order_release);
+			m_Tail.notify_all();
+		}
+
+		/* Consumer only. */
+		std::optional<T> TryPop()
+		{
+			const std::size_t head = m_Head.load(std::memory_order_relaxed);
+			if (head == m_CachedTail)
+			{
+				m_CachedTail = m_Tail.load(std::memory_order_acquire) & kIndexMask;
+				if (head == m_CachedTail)
+					return std::nullopt;
+			}
+
+			std::optional<T> value{ std::move(m_pSlots[head & m_Mask]) };
+			m_pSlots[head & m_Mask].reset();
+			m_Head.store(head + 1, std::memory_order_release);
+			m_Head.notify_one();
+			return value;
+		}
+
+		/* Consumer only. Waits for a value, nullopt once the queue is closed and empty. */
+		std::optional<T> Pop()
+		{
+			for (int spin = 0;; ++spin)
+			{
+				if (auto value = TryPop())
+					return value;
+
+				const std::size_t tail = m_Tail.load(std::memory_order_acquire);
+				if (tail & kClosedBit)
+				{
+					// Close() happens after the last push, so one more look is enough
+					return TryPop();
+				}
+
+				if (spin < kSpinLimit)
+				{
+					std::this_thread::yield();
+					continue;
+				}
+
+				if (tail == m_Head.load(std::memory_order_relaxed))
+					m_Tail.wait(tail, std::memory_order_acquire);
+			}
+		}
+
+		/* Approximate, for stats. Either side may call it. */
+		std::size_t Size() const
+		{
+			const std::size_t head = m_Head.load(std::memory_order_acquire);
+			const std::size_t tail = m_Tail.load(std::memory_order_acquire) & kIndexMask;
+			return tail - head;
+		}
+
+		std::size_t Capacity() const { return m_Capacity; }
+
+	private:
+		static constexpr int kSpinLimit{ 64 };
+		static constexpr std::size_t kClosedBit{ std::size_t{ 1 } << (sizeof(std::size_t) * 8 - 1) };
+		static constexpr std::size_t kIndexMask{ ~kClosedBit };
+
+		const std::size_t m_Capacity;
+		const std::size_t m_Mask;
+		std::unique_ptr<std::optional<T>[]> m_pSlots;
+
+		alignas(64) std::atomic<std::size_t> m_Head{ 0 };	// Next slot to pop
+		std::size_t m_CachedTail{ 0 };						// Consumer's copy of m_Tail
+
+		alignas(64) std::atomic<std::size_t> m_Tail{ 0 };	// Next slot to push, top bit = closed
+		std::size_t m_CachedHead{ 0 };						// Producer's copy of m_Head
+	};
+}
@@ -0,0 +1,392 @@
+#include "thread_pool.hpp"
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace utils
+{
+/*
+* Chase-Lev work stealing deque ("Correct and Efficient Work-Stealing for Weak
+* Memory Models", Le et al. 2013).
+* - Push/Take are only called by the owning worker.
+* - Steal may be called by any thread.
+* - When the ring buffer fills up it is doubled. Old buffers are kept until the
+* deque is destroyed, since a thief may still be reading one.
+*/
+class ThreadPool::WorkStealingDeque
+{
+public:
+	explicit WorkStealingDeque(std::int64_t capacity = 256)
+	{
+		m_Buffers.push_back(std::make_unique<Buffer>(capacity));
+		m_pBuffer.store(m_Buffers.back().get(), std::memory_order_relaxed);
+	}
+
+	void Push(Task* pTask)
+	{
+		const std::int64_t bottom = m_Bottom.load(std::memory_order_relaxed);
+		const std::int64_t top = m_Top.load(std::memory_order_acquire);
+		Buffer* pBuffer = m_pBuffer.load(std::memory_order_relaxed);
+
+		if (bottom - top > pBuffer->capacity - 1)
+			pBuffer = Grow(pBuffer, top, bottom);
+
+		pBuffer->Put(bottom, pTask);
+		std::atomic_thread_fence(std::memory_order_release);
+		m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+
+	Task* Take()
+	{
+		const std::int64_t bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+		Buffer* pBuffer = m_pBuffer.load(std::memory_order_relaxed);
+		m_Bottom.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		std::int64_t top = m_Top.load(std::memory_order_relaxed);
+
+		if (top > bottom)
+		{
+			// Empty
+			m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		Task* pTask = pBuffer->Get(bottom);
+		if (top == bottom)
+		{
+			// Last item, race the thieves for it
+			if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+				pTask = nullptr;
+			m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+		}
+		return pTask;
+	}
+
+	Task* Steal()
+	{
+		std::int64_t top = m_Top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const std::int64_t bottom = m_Bottom.load(std::memory_order_acquire);
+
+		if (top >= bottom)
+			return nullptr;
+
+		Buffer* pBuffer = m_pBuffer.load(std::memory_order_acquire);
+		Task* pTask = pBuffer->Get(top);
+		if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			return nullptr; // Lost the race to another thief or the owner
+
+		return pTask;
+	}
+
+private:
+	struct Buffer
+	{
+		explicit Buffer(std::int64_t inCapacity)
+			: capacity{ inCapacity }, mask{ inCapacity - 1 }, slots{ new std::atomic<Task*>[inCapacity] }
+		{
+		}
+
+		// Acquire/release on the slot itself publishes the task to a thief (free on x86)
+		Task* Get(std::int64_t index) const { return slots[index & mask].load(std::memory_order_acquire); }
+		void Put(std::int64_t index, Task* pTask) { slots[index & mask].store(pTask, std::memory_order_release); }
+
+		std::int64_t capacity;
+		std::int64_t mask;
+		std::unique_ptr<std::atomic<Task*>[]> slots;
+	};
+
+	Buffer* Grow(Buffer* pOld, std::int64_t top, std::int64_t bottom)
+	{
+		auto pNew = std::make_unique<Buffer>(pOld->capacity * 2);
+		for (std::int64_t i = top; i < bottom; ++i)
+			pNew->Put(i, pOld->Get(i));
+
+		m_Buffers.push_back(std::move(pNew));
+		m_pBuffer.store(m_Buffers.back().get(), std::memory_order_release);
+		return m_Buffers.back().get();
+	}
+
+	alignas(64) std::atomic<std::int64_t> m_Top{ 0 };
+	alignas(64) std::atomic<std::int64_t> m_Bottom{ 0 };
+	std::atomic<Buffer*> m_pBuffer{ nullptr };
+	std::vector<std::unique_ptr<Buffer>> m_Buffers; // Owner only
+};
+
+struct ThreadPool::Worker
+{
+	WorkStealingDeque deque{};
+};
+
+namespace
+{
+	/* Which pool (if any) the current thread works for, and its slot in it. */
+	thread_local const void* tpCurrentPool{ nullptr };
+	thread_local std::size_t tWorkerIndex{ 0 };
+
+	std::size_t NextRandom()
+	{
+		thread_local std::uint64_t state{
+			std::hash<std::thread::id>{}(std::this_thread::get_id()) | 1u
+		};
+		// xorshift64
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return static_cast<std::size_t>(state);
+	}
+
+	/* Parses a sysfs cpu list such as "0-3,8,10-11". */
+	std::vector<int> ParseCpuList(const std::string& text)
+	{
+		std::vector<int> cpus;
+		std::stringstream stream{ text };
+		std::string range;
+		while (std::getline(stream, range, ','))
+		{
+			if (range.empty() || range == "\n")
+				continue;
+
+			const auto dash = range.find('-');
+			const int first = std::stoi(range.substr(0, dash));
+			const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+			for (int cpu = first; cpu <= last; ++cpu)
+				cpus.push_back(cpu);
+		}
+		return cpus;
+	}
+
+	/* CPUs grouped by NUMA node. Machines without NUMA info are one node. */
+	std::vector<std::vector<int>> NumaTopology()
+	{
+		std::vector<std::vector<int>> nodes;
+#if defined(__linux__)
+		for (int node = 0;; ++node)
+		{
+			std::ifstream file{ "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist" };
+			if (!file.is_open())
+				break;
+
+			std::string text;
+			std::getline(file, text);
+			auto cpus = ParseCpuList(text);
+			if (!cpus.empty())
+				nodes.push_back(std::move(cpus));
+		}
+
+		if (nodes.empty())
+		{
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			if (sched_getaffinity(0, sizeof(set), &set) == 0)
+			{
+				std::vector<int> cpus;
+				for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+				{
+					if (CPU_ISSET(cpu, &set))
+						cpus.push_back(cpu);
+				}
+				nodes.push_back(std::move(cpus));
+			}
+		}
+#endif
+		return nodes;
+	}
+
+	/* The CPU each worker should be pinned to, or -1 for no pinning. */
+	std::vector<int> PlaceWorkers(std::size_t threadCount, AffinityPolicy policy)
+	{
+		std::vector<int> placement(threadCount, -1);
+		if (policy == AffinityPolicy::None)
+			return placement;
+
+		const auto nodes = NumaTopology();
+		if (nodes.empty())
+			return placement;
+
+		if (policy == AffinityPolicy::Compact)
+		{
+			std::vector<int> cpus;
+			for (const auto& node : nodes)
+				cpus.insert(cpus.end(), node.begin(), node.end());
+
+			for (std::size_t i = 0; i < threadCount; ++i)
+				placement[i] = cpus[i % cpus.size()];
+		}
+		else
+		{
+			for (std::size_t i = 0; i < threadCount; ++i)
+			{
+				const auto& node = nodes[i % nodes.size()];
+				placement[i] = node[(i / nodes.size()) % node.size()];
+			}
+		}
+		return placement;
+	}
+
+	void PinCurrentThread(int cpu)
+	{
+#if defined(__linux__)
+		if (cpu < 0)
+			return;
+
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+		(void)cpu;
+#endif
+	}
+}
+
+ThreadPool::ThreadPool(std::size_t threadCount)
+	: ThreadPool{ ThreadPoolConfig{ .threadCount = threadCount } }
+{
+}
+
+ThreadPool::ThreadPool(const ThreadPoolConfig& config)
+{
+	const std::size_t threadCount = config.threadCount > 0
+		? config.threadCount
+		: std::max(1u, std::thread::hardware_concurrency());
+
+	m_Workers.reserve(threadCount);
+	for (std::size_t i = 0; i < threadCount; ++i)
+		m_Workers.push_back(std::make_unique<Worker>());
+
+	const auto placement = PlaceWorkers(threadCount, config.affinity);
+	m_Threads.reserve(threadCount);
+	for (std::size_t i = 0; i < threadCount; ++i)
+		m_Threads.emplace_back(&ThreadPool::WorkerLoop, this, i, placement[i]);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard lock{ m_SleepMutex };
+		m_bStop = true;
+	}
+	m_SleepCondition.notify_all();
+
+	for (auto& thread : m_Threads)
+		thread.join();
+}
+
+void ThreadPool::Schedule(Task* pTask)
+{
+	// Count first, so m_Pending never reads lower than what is actually queued
+	m_Pending.fetch_add(1, std::memory_order_seq_cst);
+
+	if (tpCurrentPool == this)
+	{
+		m_Workers[tWorkerIndex]->deque.Push(pTask);
+	}
+	else
+	{
+		std::lock_guard lock{ m_InjectMutex };
+		m_Injected.push_back(pTask);
+	}
+
+	if (m_Sleeping.load(std::memory_order_seq_cst) > 0)
+	{
+		// Taking the lock makes sure a worker about to sleep sees the new task or gets woken
+		std::lock_guard lock{ m_SleepMutex };
+		m_SleepCondition.notify_one();
+	}
+}
+
+ThreadPool::Task* ThreadPool::FindTask(std::size_t selfIndex)
+{
+	// 1) Our own deque
+	if (selfIndex < m_Workers.size())
+	{
+		if (Task* pTask = m_Workers[selfIndex]->deque.Take())
+			return pTask;
+	}
+
+	// 2) Work from outside the pool
+	{
+		std::unique_lock lock{ m_InjectMutex, std::try_to_lock };
+		if (lock.owns_lock() && !m_Injected.empty())
+		{
+			Task* pTask = m_Injected.front();
+			m_Injected.pop_front();
+			return pTask;
+		}
+	}
+
+	// 3) Steal, starting from a random victim so thieves don't all pile onto one worker
+	const std::size_t count = m_Workers.size();
+	const std::size_t start = NextRandom() % count;
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		const std::size_t victim = (start + i) % count;
+		if (victim == selfIndex)
+			continue;
+
+		if (Task* pTask = m_Workers[victim]->deque.Steal())
+			return pTask;
+	}
+
+	return nullptr;
+}
+
+bool ThreadPool::RunPendingTask()
+{
+	const std::size_t selfIndex = tpCurrentPool == this ? tWorkerIndex : m_Workers.size();
+	Task* pTask = FindTask(selfIndex);
+	if (!pTask)
+		return false;
+
+	m_Pending.fetch_sub(1, std::memory_order_relaxed);
+	std::unique_ptr<Task> pOwned{ pTask };
+	pOwned->Run();
+	return true;
+}
+
+void ThreadPool::WorkerLoop(std::size_t index, int cpu)
+{
+	tpCurrentPool = this;
+	tWorkerIndex = index;
+	PinCurrentThread(cpu);
+
+	for (;;)
+	{
+		if (RunPendingTask())
+			continue;
+
+		// Spin briefly before sleeping, new work often shows up right away
+		bool bFound{ false };
+		for (int spin = 0; spin < 64 && !bFound; ++spin)
+		{
+			std::this_thread::yield();
+			bFound = RunPendingTask();
+		}
+		if (bFound)
+			continue;
+
+		std::unique_lock lock{ m_SleepMutex };
+		m_Sleeping.fetch_add(1, std::memory_order_seq_cst);
+		m_SleepCondition.wait(lock,
+			[this] { return m_bStop || m_Pending.load(std::memory_order_seq_cst) > 0; });
+		m_Sleeping.fetch_sub(1, std::memory_order_relaxed);
+
+		if (m_bStop && m_Pending.load(std::memory_order_acquire) == 0)
+			break;
+	}
+}
+
+ThreadPool& DefaultThreadPool()
+{
+	static ThreadPool pool{};
+	return pool;
+}
+
+}
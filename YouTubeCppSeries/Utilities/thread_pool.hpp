@@ -0,0 +1,190 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace utils
+{
+	/*
+	* Where the worker threads are allowed to run.
+	* - None		-> Let the OS decide.
+	* - Compact	-> Fill one NUMA node before moving to the next (shares caches).
+	* - Scatter	-> Round robin across NUMA nodes (spreads memory bandwidth).
+	*/
+	enum class AffinityPolicy
+	{
+		None,
+		Compact,
+		Scatter
+	};
+
+	struct ThreadPoolConfig
+	{
+		std::size_t threadCount{ 0 };	// 0 = one per hardware thread
+		AffinityPolicy affinity{ AffinityPolicy::None };
+	};
+
+	/*
+	* Work Stealing Thread Pool
+	* - Every worker owns a Chase-Lev deque. It pushes and pops its own work at the bottom
+	* (LIFO, cache friendly) while idle workers steal from the top (FIFO).
+	* - Tasks submitted from outside the pool go to a shared injection queue.
+	* - Threads are created once, so submitting work never pays thread creation.
+	*/
+	class ThreadPool
+	{
+	public:
+		explicit ThreadPool(std::size_t threadCount = 0);
+		explicit ThreadPool(const ThreadPoolConfig& config);
+		~ThreadPool(); // Runs everything already queued, then joins
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		/*
+		* Queue a callable and get a future for its result.
+		* NOTE: Blocking on the future from inside a pool task wastes a worker.
+		* Prefer ParallelFor, which helps run other tasks while it waits.
+		*/
+		template <typename Func, typename... Args>
+		auto Submit(Func&& func, Args&&... args)
+			-> std::future<std::invoke_result_t<std::decay_t<Func>, std::decay_t<Args>...>>
+		{
+			using Result = std::invoke_result_t<std::decay_t<Func>, std::decay_t<Args>...>;
+			std::packaged_task<Result()> task{
+				[func = std::forward<Func>(func), ... args = std::forward<Args>(args)]() mutable
+				{
+					return std::invoke(std::move(func), std::move(args)...);
+				}
+			};
+
+			auto future = task.get_future();
+			Schedule(MakeTask(std::move(task)));
+			return future;
+		}
+
+		/* Queue a callable without a future, for fire-and-forget work. */
+		template <typename Func>
+		void Post(Func&& func)
+		{
+			Schedule(MakeTask(std::forward<Func>(func)));
+		}
+
+		/*
+		* Calls func(i) for every i in [begin, end), split into chunks of 'grain' indices.
+		* The calling thread runs chunks too, so this is safe to call from inside a task.
+		* The first exception thrown by func is rethrown here once every chunk is done.
+		*/
+		template <typename Index, typename Func>
+		void ParallelFor(Index begin, Index end, Func&& func, Index grain = Index{ 0 })
+		{
+			static_assert(std::is_integral_v<Index>, "ParallelFor needs an integral index");
+			if (begin >= end)
+				return;
+
+			const auto count = static_cast<std::size_t>(end - begin);
+			std::size_t chunk = grain > Index{ 0 }
+				? static_cast<std::size_t>(grain)
+				: std::max<std::size_t>(1, count / (Size() * 4));
+			const std::size_t chunkCount = (count + chunk - 1) / chunk;
+
+			std::atomic<std::size_t> remaining{ chunkCount };
+			std::exception_ptr pError{ nullptr };
+			std::mutex errorMutex;
+
+			auto runChunk = [&](std::size_t chunkIndex)
+			{
+				const Index lo = begin + static_cast<Index>(chunkIndex * chunk);
+				const Index hi = static_cast<Index>(std::min<std::size_t>((chunkIndex + 1) * chunk, count)) + begin;
+				try
+				{
+					for (Index i = lo; i < hi; ++i)
+						func(i);
+				}
+				catch (...)
+				{
+					std::lock_guard lock{ errorMutex };
+					if (!pError)
+						pError = std::current_exception();
+				}
+				remaining.fetch_sub(1, std::memory_order_acq_rel);
+			};
+
+			for (std::size_t c = 1; c < chunkCount; ++c)
+			{
+				Schedule(MakeTask([&runChunk, c] { runChunk(c); }));
+			}
+
+			runChunk(0);
+			while (remaining.load(std::memory_order_acquire) != 0)
+			{
+				if (!RunPendingTask())
+					std::this_thread::yield();
+			}
+
+			if (pError)
+				std::rethrow_exception(pError);
+		}
+
+		std::size_t Size() const { return m_Workers.size(); }
+
+		/* Runs one queued task on the calling thread. Returns false if none was found. */
+		bool RunPendingTask();
+
+	private:
+		struct Task
+		{
+			virtual ~Task() = default;
+			virtual void Run() = 0;
+		};
+
+		template <typename Func>
+		struct TaskImpl final : Task
+		{
+			template <typename F>
+			explicit TaskImpl(F&& inFunc) : func{ std::forward<F>(inFunc) } {}
+			void Run() override { func(); }
+			Func func;
+		};
+
+		template <typename Func>
+		static Task* MakeTask(Func&& func)
+		{
+			return new TaskImpl<std::decay_t<Func>>(std::forward<Func>(func));
+		}
+
+		class WorkStealingDeque;
+		struct Worker;
+
+		void Schedule(Task* pTask);
+		Task* FindTask(std::size_t selfIndex);
+		void WorkerLoop(std::size_t index, int cpu);
+
+		std::vector<std::unique_ptr<Worker>> m_Workers;
+		std::vector<std::thread> m_Threads;
+
+		// Work submitted from threads that are not part of this pool
+		std::mutex m_InjectMutex;
+		std::deque<Task*> m_Injected;
+
+		std::atomic<std::size_t> m_Pending{ 0 };
+		std::atomic<std::size_t> m_Sleeping{ 0 };
+		std::mutex m_SleepMutex;
+		std::condition_variable m_SleepCondition;
+		bool m_bStop{ false };
+	};
+
+	/* A shared pool with one worker per hardware thread, created on first use. */
+	ThreadPool& DefaultThreadPool();
+}
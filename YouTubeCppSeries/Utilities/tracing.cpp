@@ -0,0 +1,242 @@
+#include "tracing.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+
+namespace utils
+{
+namespace
+{
+	// Lives here rather than in the header so the library and the executables share one copy
+	std::atomic<std::uint32_t> gSampleRate{ 1 };
+
+	/* One recorded span. Fields are atomics so the exporter can read while the owner writes. */
+	struct Slot
+	{
+		std::atomic<const char*> name{ nullptr };
+		std::atomic<std::uint64_t> beginTicks{ 0 };
+		std::atomic<std::uint64_t> endTicks{ 0 };
+		std::atomic<std::uint32_t> threadId{ 0 };
+	};
+
+	/*
+	* A ring written by exactly one thread at a time.
+	* 'head' counts every span ever written, the slot is head % kRingCapacity.
+	*/
+	struct ThreadRing
+	{
+		std::array<Slot, Tracer::kRingCapacity> slots{};
+		std::atomic<std::uint64_t> head{ 0 };
+		bool bInUse{ false };	// Guarded by the registry mutex
+	};
+
+	/*
+	* Owns every ring. When a thread exits its ring is handed to the next new thread,
+	* so short-lived threads don't grow memory forever. Spans keep the id of the
+	* thread that recorded them.
+	* Never destroyed, so threads that exit during shutdown can still give their ring back.
+	*/
+	struct Registry
+	{
+		std::mutex mutex;
+		std::vector<std::unique_ptr<ThreadRing>> rings;
+		std::uint32_t nextThreadId{ 1 };
+	};
+
+	Registry& GetRegistry()
+	{
+		static Registry* pRegistry{ new Registry{} };
+		return *pRegistry;
+	}
+
+	struct LocalRing
+	{
+		LocalRing()
+		{
+			Registry& registry = GetRegistry();
+			std::lock_guard lock{ registry.mutex };
+
+			threadId = registry.nextThreadId++;
+			auto it = std::find_if(registry.rings.begin(), registry.rings.end(),
+				[](const auto& pRing) { return !pRing->bInUse; });
+			if (it == registry.rings.end())
+			{
+				registry.rings.push_back(std::make_unique<ThreadRing>());
+				it = std::prev(registry.rings.end());
+			}
+
+			pRing = it->get();
+			pRing->bInUse = true;
+		}
+
+		~LocalRing()
+		{
+			Registry& registry = GetRegistry();
+			std::lock_guard lock{ registry.mutex };
+			pRing->bInUse = false;
+		}
+
+		LocalRing(const LocalRing&) = delete;
+		LocalRing& operator=(const LocalRing&) = delete;
+
+		ThreadRing* pRing{ nullptr };
+		std::uint32_t threadId{ 0 };
+	};
+
+	LocalRing& GetLocalRing()
+	{
+		thread_local LocalRing local{};
+		return local;
+	}
+
+	struct Span
+	{
+		const char* name;
+		std::uint64_t beginTicks;
+		std::uint64_t endTicks;
+		std::uint32_t threadId;
+	};
+
+	/* Span names are usually literals, but escape them anyway so the JSON stays valid. */
+	void AppendEscaped(fmt::memory_buffer& out, std::string_view text)
+	{
+		for (const char c : text)
+		{
+			switch (c)
+			{
+			case '"': out.append(std::string_view{ "\\\"" }); break;
+			case '\\': out.append(std::string_view{ "\\\\" }); break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20)
+					fmt::format_to(std::back_inserter(out), "\\u{:04x}", static_cast<int>(c));
+				else
+					out.push_back(c);
+			}
+		}
+	}
+}
+
+void Tracer::SetSampleRate(std::uint32_t rate)
+{
+	gSampleRate.store(rate, std::memory_order_relaxed);
+}
+
+std::uint32_t Tracer::SampleRate()
+{
+	return gSampleRate.load(std::memory_order_relaxed);
+}
+
+void Tracer::Record(const char* name, std::uint64_t beginTicks, std::uint64_t endTicks)
+{
+	LocalRing& local = GetLocalRing();
+	ThreadRing& ring = *local.pRing;
+
+	const std::uint64_t head = ring.head.load(std::memory_order_relaxed);
+	Slot& slot = ring.slots[head % kRingCapacity];
+
+	/*
+	* Seqlock write side: an exporter that reads any of the stores below is
+	* guaranteed to see head >= this one afterwards, so it knows the slot was reused.
+	*/
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.name.store(name, std::memory_order_relaxed);
+	slot.beginTicks.store(beginTicks, std::memory_order_relaxed);
+	slot.endTicks.store(endTicks, std::memory_order_relaxed);
+	slot.threadId.store(local.threadId, std::memory_order_relaxed);
+
+	// Publishes the slot to the exporter
+	ring.head.store(head + 1, std::memory_order_release);
+}
+
+void Tracer::WriteChromeTrace(std::ostream& out)
+{
+	std::vector<Span> spans;
+	{
+		Registry& registry = GetRegistry();
+		std::lock_guard lock{ registry.mutex };
+		for (const auto& pRing : registry.rings)
+		{
+			const std::uint64_t end = pRing->head.load(std::memory_order_acquire);
+			const std::uint64_t begin = end > kRingCapacity ? end - kRingCapacity : 0;
+
+			const std::size_t first = spans.size();
+			for (std::uint64_t i = begin; i < end; ++i)
+			{
+				const Slot& slot = pRing->slots[i % kRingCapacity];
+				spans.push_back({
+					slot.name.load(std::memory_order_relaxed),
+					slot.beginTicks.load(std::memory_order_relaxed),
+					slot.endTicks.load(std::memory_order_relaxed),
+					slot.threadId.load(std::memory_order_relaxed) });
+			}
+
+			/*
+			* The owner may have lapped us while we copied. Drop any slot it could have touched.
+			* Seqlock read side: the fence keeps the relaxed slot loads above from moving
+			* below this load (an acquire load alone only orders what comes after it).
+			*/
+			std::atomic_thread_fence(std::memory_order_acquire);
+			const std::uint64_t after = pRing->head.load(std::memory_order_relaxed);
+			const std::uint64_t firstSafe = after + 1 > kRingCapacity ? after + 1 - kRingCapacity : 0;
+			if (firstSafe > begin)
+			{
+				const auto overwritten = static_cast<std::size_t>(std::min(firstSafe, end) - begin);
+				spans.erase(spans.begin() + static_cast<std::ptrdiff_t>(first),
+					spans.begin() + static_cast<std::ptrdiff_t>(first + overwritten));
+			}
+		}
+	}
+
+	// Timestamps are microseconds from the first span, which is what the viewers expect
+	std::uint64_t origin{ ~0ull };
+	for (const Span& span : spans)
+		origin = std::min(origin, span.beginTicks);
+
+	fmt::memory_buffer buffer;
+	buffer.append(std::string_view{ "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[" });
+	bool bFirst{ true };
+	for (const Span& span : spans)
+	{
+		if (!bFirst)
+			buffer.push_back(',');
+		bFirst = false;
+
+		buffer.append(std::string_view{ "\n{\"name\":\"" });
+		AppendEscaped(buffer, span.name ? span.name : "");
+		fmt::format_to(std::back_inserter(buffer),
+			"\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+			span.threadId,
+			CycleClock::ToNanoseconds(span.beginTicks - origin) / 1000.0,
+			CycleClock::ToNanoseconds(span.endTicks - span.beginTicks) / 1000.0);
+	}
+	buffer.append(std::string_view{ "\n]}\n" });
+
+	out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+}
+
+bool Tracer::WriteChromeTrace(const std::filesystem::path& path)
+{
+	std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+	if (!file.is_open())
+		return false;
+
+	WriteChromeTrace(file);
+	return static_cast<bool>(file);
+}
+
+void Tracer::Clear()
+{
+	Registry& registry = GetRegistry();
+	std::lock_guard lock{ registry.mutex };
+	for (const auto& pRing : registry.rings)
+		pRing->head.store(0, std::memory_order_relaxed);
+}
+
+}
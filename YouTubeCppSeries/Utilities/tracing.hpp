@@ -0,0 +1,106 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+
+#include "cycle_clock.hpp"
+
+/*
+* Tracing can be compiled out completely (CMake option CPPSERIES_TRACING=OFF).
+* TRACE_SCOPE then expands to nothing, so it costs literally zero.
+*/
+#ifndef CPPSERIES_TRACING_ENABLED
+#define CPPSERIES_TRACING_ENABLED 1
+#endif
+
+namespace utils
+{
+	/*
+	* Tracer
+	* - Every thread records its spans into its own ring buffer, so recording never
+	* takes a lock or shares a cache line with another thread.
+	* - When a ring is full the oldest spans are overwritten. The latest
+	* kRingCapacity spans per thread are what you get.
+	* - WriteChromeTrace() dumps every ring as Chrome trace-event JSON. Open it in
+	* chrome://tracing or https://ui.perfetto.dev to see all threads on one timeline.
+	*/
+	class Tracer
+	{
+	public:
+		static constexpr std::size_t kRingCapacity{ 8192 };
+
+		/*
+		* Record 1 in every 'rate' spans per thread (1 = all of them, 0 = none).
+		* Sampling happens when the span starts, so a skipped span costs a counter decrement.
+		*/
+		static void SetSampleRate(std::uint32_t rate);
+		static std::uint32_t SampleRate();
+
+		static bool ShouldSample()
+		{
+			const std::uint32_t rate = SampleRate();
+			if (rate <= 1)
+				return rate == 1;
+
+			thread_local std::uint32_t countdown{ 0 };
+			if (countdown == 0)
+			{
+				countdown = rate - 1;
+				return true;
+			}
+			--countdown;
+			return false;
+		}
+
+		/* Adds a finished span to the calling thread's ring. 'name' must outlive the tracer (use literals). */
+		static void Record(const char* name, std::uint64_t beginTicks, std::uint64_t endTicks);
+
+		/*
+		* Write everything recorded so far. Safe to call while other threads are still
+		* tracing, spans they overwrite during the export are simply left out.
+		*/
+		static void WriteChromeTrace(std::ostream& out);
+		static bool WriteChromeTrace(const std::filesystem::path& path);
+
+		/* Drops every recorded span. Only call when nobody is tracing. */
+		static void Clear();
+	};
+
+	/*
+	* ScopedSpan
+	* - RAII: takes a timestamp when created and records the span when destroyed.
+	* - Use it through TRACE_SCOPE so it disappears when tracing is compiled out.
+	*/
+	class ScopedSpan
+	{
+	public:
+		explicit ScopedSpan(const char* name)
+			: m_pName{ Tracer::ShouldSample() ? name : nullptr }
+			, m_BeginTicks{ m_pName ? CycleClock::Now() : 0 }
+		{
+		}
+
+		~ScopedSpan()
+		{
+			if (m_pName)
+				Tracer::Record(m_pName, m_BeginTicks, CycleClock::Now());
+		}
+
+		ScopedSpan(const ScopedSpan&) = delete;
+		ScopedSpan& operator=(const ScopedSpan&) = delete;
+
+	private:
+		const char* m_pName;	// nullptr when this span wasn't sampled
+		std::uint64_t m_BeginTicks;
+	};
+}
+
+#define CPPSERIES_TRACE_CONCAT_INNER(a, b) a##b
+#define CPPSERIES_TRACE_CONCAT(a, b) CPPSERIES_TRACE_CONCAT_INNER(a, b)
+
+#if CPPSERIES_TRACING_ENABLED
+/* TRACE_SCOPE("Service::DoSomething"); -> times the rest of the enclosing scope */
+#define TRACE_SCOPE(name) const ::utils::ScopedSpan CPPSERIES_TRACE_CONCAT(traceSpan_, __LINE__){ name }
+#else
+#define TRACE_SCOPE(name) static_cast<void>(0)
+#endif
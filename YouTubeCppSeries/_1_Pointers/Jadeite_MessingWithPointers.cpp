@@ -1,5 +1,10 @@
 #include <iostream>
 #include <memory>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "../Utilities/epoch_reclamation.hpp"
 
 void RawPointerExamples()
 {
@@ -103,6 +108,80 @@ void WeakPtrExamples()
 	// Both Objects will be properly destroyed
 }
 
+/*
+* Epoch Based Reclamation
+* - shared_ptr/weak_ptr keep objects alive by updating an atomic ref count on every copy and lock().
+* - With many readers, every one of them writes to the same count, and that does not scale.
+* - With epochs, readers only pin the current epoch while they look at the data.
+* - Writers unlink nodes and retire them. The delete happens later, once no reader can still see them.
+*/
+struct Node
+{
+	int value{ 0 };
+	std::atomic<Node*> pNext{ nullptr };
+};
+
+void EpochReclamationExamples()
+{
+	// Build a small shared list: 1 -> 2 -> 3
+	std::atomic<Node*> pHead{ new Node{ 1 } };
+	Node* pSecond = new Node{ 2 };
+	pSecond->pNext.store(new Node{ 3 });
+	pHead.load()->pNext.store(pSecond);
+
+	std::atomic<bool> bDone{ false };
+	std::vector<std::thread> readers;
+	for (int i = 0; i < 3; ++i)
+	{
+		readers.emplace_back(
+			[&pHead, &bDone]
+			{
+				while (!bDone.load())
+				{
+					// No ref counts are touched while walking the list
+					utils::EpochGuard guard{};
+					int sum{ 0 };
+					for (Node* pNode = pHead.load(std::memory_order_acquire); pNode;
+						pNode = pNode->pNext.load(std::memory_order_acquire))
+					{
+						sum += pNode->value;
+					}
+				}
+			}
+		);
+	}
+
+	// The writer keeps replacing the head node and retires the old one
+	for (int i = 0; i < 1000; ++i)
+	{
+		Node* pOld = pHead.load();
+		Node* pNew = new Node{ pOld->value + 1 };
+		pNew->pNext.store(pOld->pNext.load());
+		pHead.store(pNew, std::memory_order_release);
+
+		// We can't delete pOld yet. A reader could still be looking at it.
+		utils::EpochDomain::Retire(pOld);
+		utils::EpochDomain::Collect();
+	}
+
+	bDone.store(true);
+	for (auto& reader : readers)
+		reader.join();
+
+	std::cout << "Head value: " << pHead.load()->value
+		<< " Nodes waiting to be freed: " << utils::EpochDomain::PendingCount() << std::endl;
+
+	// Every reader has finished, it is safe to free it all now.
+	Node* pNode = pHead.load();
+	while (pNode)
+	{
+		Node* pNext = pNode->pNext.load();
+		delete pNode;
+		pNode = pNext;
+	}
+	utils::EpochDomain::DrainAll();
+}
+
 void LegacyFunction(int* rawPtr)
 {
 	// Change te value
@@ -125,6 +204,9 @@ int main()
 	std::cout << "Weak Ptr Examples\n";
 	WeakPtrExamples();
 	std::cout << "\n=============================\n";
+	std::cout << "Epoch Reclamation Examples\n";
+	EpochReclamationExamples();
+	std::cout << "\n=============================\n";
 	std::cout << "Legacy Function Example\n";
 	auto ptr1 = std::make_unique<int>(74);
 	std::cout << "Old Value: " << *ptr1 << "\n";
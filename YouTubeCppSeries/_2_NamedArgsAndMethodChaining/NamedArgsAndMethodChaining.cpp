@@ -1,5 +1,14 @@
+#include <chrono>
+#include <cstddef>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <vector>
+
+#include "NamedArgsAndMethodChaining.hpp"
+#include "character_index.hpp"
+#include "character_serialization.hpp"
+#include "character_spawn_pipeline.hpp"
 
 // ===================================================================================
 // Named Arguments
@@ -12,7 +21,7 @@
 void CreateCharacter(const std::string& sName, int health, int mana, int level, bool bIsNPC)
 {
 	std::cout << "Creating Old Character " << sName << " with HP: " << health
-		<< " and MP: " << mana << "\n";
+		<< ", MP: " << mana << ", Level: " << level << (bIsNPC ? " (NPC)" : "") << "\n";
 }
 
 void CallOldCreateCharacterExample()
@@ -25,21 +34,14 @@ void CallOldCreateCharacterExample()
 
 /*
 * Solution - Create a new struct with named fields
+* See CharacterParams in NamedArgsAndMethodChaining.hpp
 */
-struct CharacterParams
-{
-	std::string sName{ "" };
-	int health{ 0 };
-	int mana{ 0 };
-	int level{ 1 };
-	bool bIsNPC{ false };
-};
 
 // We can then make a cleaner function
 void CreateCharacter(const CharacterParams& params)
 {
 	std::cout << "Creating New Character " << params.sName << " with HP: " << params.health
-		<< " and MP: " << params.mana << "\n";
+		<< ", MP: " << params.mana << ", Level: " << params.level << (params.bIsNPC ? " (NPC)" : "") << "\n";
 }
 
 /*
@@ -58,29 +60,7 @@ void CallNewCreateCharacterExample()
 // ===================================================================================
 // Method Chaining
 // ===================================================================================
-
-// Character Builder class
-class Character
-{
-private:
-	std::string sName{ "" };
-	int health{ 0 };
-	int mana{ 0 };
-	int level{ 1 };
-	bool bIsNPC{ false };
-
-public:
-	Character& SetName(const std::string& name) { sName = name; return *this; }
-	Character& SetHealth(int inHealth) { health = inHealth; return *this; }
-	Character& SetMana(int inMana) { mana = inMana; return *this; }
-	Character& SetLevel(int inLevel) { level = inLevel; return *this; }
-	Character& SetAsNPC(bool npc) { bIsNPC = npc; return *this; }
-
-	void Print() const {
-		std::cout << "Character " << sName 
-			<< " (Lvl " << level << ") HP: " << health << " Mana: " << mana << "\n";
-	}
-};
+// Character, Settings and CharacterBuilder live in NamedArgsAndMethodChaining.hpp
 
 void CreateBuilderCharacter()
 {
@@ -98,42 +78,6 @@ void CreateBuilderCharacter()
 		.SetLevel(3);
 }
 
-/* 
-* Here's another example of Method chaining that does not use a build pattern.
-* Imagine we have a configuration system where we can set various options dynamically
-*/
-
-class Settings
-{
-private:
-	bool bFullscreen{ false };
-	int resolutionWidth{ 1920 };
-	int resolutionHeight{ 1080 };
-	int volume{ 50 };
-
-public:
-	Settings& SetFullScreenMode(bool fullscreen) { bFullscreen = fullscreen; return *this; }
-	Settings& SetResolution(int width, int height) 
-	{ 
-		resolutionWidth = width; 
-		resolutionHeight = height; 
-		return *this; 
-	}
-	Settings& SetVolume(int inVolume) 
-	{ 
-		volume = inVolume; 
-		return *this; 
-	}
-
-	void Apply() const
-	{
-		std::cout << "Applying Settings:\n"
-			<< "Fullscreen: " << (bFullscreen ? "Enabled" : "Disabled") << "\n"
-			<< "Resolution: " << resolutionWidth << " x " << resolutionHeight << "\n"
-			<< "Volume: " << volume << "\n";
- 	}
-};
-
 /* Configure settings Examples */
 void ConfigureSettingsExamples()
 {
@@ -151,33 +95,122 @@ void ConfigureSettingsExamples()
 // ===================================================================================
 // Combining Named Arguments with Method Chaining
 // ===================================================================================
-/*
-* Alright Now let's combine the two
-*/
-class CharacterBuilder
+void CombinedNamedArgsAndMethodChaining()
 {
-private:
-	Character character;
+	Character hero = CharacterBuilder().name("Jadeite").health(450).mana(12).build();
+	hero.Print();
+}
 
-public:
-	CharacterBuilder& name(const std::string& name) { character.SetName(name); return *this; }
-	CharacterBuilder& health(int health) { character.SetHealth(health); return *this; }
-	CharacterBuilder& mana(int mana) { character.SetMana(mana); return *this; }
-	CharacterBuilder& level(int level) { character.SetLevel(level); return *this; }
-	CharacterBuilder& npc(bool npc) { character.SetAsNPC(npc); return *this; }
+// ===================================================================================
+// Spawning a wave of Characters
+// ===================================================================================
+// See character_spawn_pipeline.hpp
+void SpawnCharacterWave()
+{
+	// A few hand written characters, one of them broken and one out of range
+	std::istringstream csv{
+		"name,health,mana,level,npc\n"
+		"Jadeite,450,12,7,0\n"
+		"Shopkeeper,100,0,1,1\n"
+		"Broken,lots,0,1,0\n"
+		"Ghost,0,10,3,1\n"
+	};
+
+	std::vector<Character> town;
+	CharacterSpawnPipeline pipeline{};
+	const SpawnReport townReport = pipeline.Run(csv, town);
+	for (const Character& character : town)
+		character.Print();
+	std::cout << "Spawned " << townReport.spawned << ", rejected " << townReport.rejected
+		<< ", malformed " << townReport.malformed << "\n";
+
+	// A big wave, this is where the pipeline pays off
+	std::vector<CharacterParams> wave;
+	wave.reserve(200'000);
+	for (int i = 0; i < 200'000; ++i)
+	{
+		wave.push_back({ .sName = "Goblin_" + std::to_string(i), .health = 50 + i % 50,
+			.mana = i % 20, .level = 1 + i % 100, .bIsNPC = true });
+	}
 
-	Character build() { return character; }
-};
+	std::vector<Character> army;
+	CharacterSpawnPipeline wavePipeline{ { .batchSize = 4096 } };
+	wavePipeline.Run(wave, army).Print();
+}
 
-void CombinedNamedArgsAndMethodChaining()
+// ===================================================================================
+// Saving and loading Characters
+// ===================================================================================
+// See character_serialization.hpp
+void SnapshotCharacters()
 {
-	Character hero = CharacterBuilder().name("Jadeite").health(450).mana(12).build();
-	hero.Print();
+	std::vector<Character> army;
+	army.reserve(1'000'000);
+	for (int i = 0; i < 1'000'000; ++i)
+	{
+		army.push_back(CharacterBuilder().name("Goblin_" + std::to_string(i))
+			.health(50 + i % 50).mana(i % 20).level(1 + i % 100).npc(true).build());
+	}
+
+	using Clock = std::chrono::steady_clock;
+	const auto start = Clock::now();
+	std::vector<std::byte> snapshot;
+	utils::BinaryWriter<Character> writer{ snapshot };
+	writer.Write(std::span<const Character>{ army });
+	const auto encoded = Clock::now();
+
+	std::vector<Character> loaded;
+	const utils::BinaryReader<Character> reader{ snapshot };
+	reader.ReadAll(loaded);
+	const auto decoded = Clock::now();
+
+	using Ms = std::chrono::duration<double, std::milli>;
+	std::cout << "Snapshot of " << writer.Count() << " characters: " << snapshot.size() << " bytes, "
+		<< Ms(encoded - start).count() << "ms to save, " << Ms(decoded - encoded).count() << "ms to load\n";
+
+	// No need to decode a whole Character just to look at one field
+	for (const utils::RecordView<Character> record : reader)
+	{
+		std::cout << "First record: " << record.Get<0>() << " (Lvl "
+			<< record.Get<utils::RecordView<Character>::IndexOf("level")>() << ")\n";
+		break;
+	}
+	loaded.front().Print();
+}
+
+// ===================================================================================
+// Finding Characters
+// ===================================================================================
+// See character_index.hpp
+void QueryCharacters()
+{
+	CharacterIndex index;
+	std::vector<Character> population;
+	population.reserve(100'000);
+	for (int i = 0; i < 100'000; ++i)
+	{
+		population.push_back(CharacterBuilder().name("Villager_" + std::to_string(i))
+			.health(i * 37 % 1000).level(1 + i % 100).npc(i % 3 == 0).build());
+	}
+	index.Add(population);
+
+	// Named arguments again: NPCs with level 5-10 and health under 50
+	const CharacterFilter weakNpcs{ .bIsNPC = true, .minLevel = 5, .maxLevel = 10, .maxHealth = 49 };
+	std::cout << "Weak NPCs: " << index.Find(weakNpcs).size() << "\n";
+
+	// Edits chain like Character's setters and keep the index up to date
+	const CharacterId hero = index.Add(CharacterBuilder().name("Jadeite").health(450).level(7).build());
+	index.Edit(hero).SetHealth(20).SetAsNPC(true);
+	std::cout << "Weak NPCs after Jadeite got hurt: " << index.Find(weakNpcs).size() << "\n";
+	index.Get(hero).Print();
 }
 
 int main()
 {
 	ConfigureSettingsExamples();
 	CombinedNamedArgsAndMethodChaining();
+	SpawnCharacterWave();
+	SnapshotCharacters();
+	QueryCharacters();
 	return 0;
 }
@@ -0,0 +1,122 @@
+#pragma once
+#include <iostream>
+#include <string>
+
+#include "../Utilities/tracing.hpp"
+
+namespace utils
+{
+	template <typename T>
+	struct Reflect;
+}
+
+// ===================================================================================
+// Named Arguments
+// ===================================================================================
+/*
+* Named fields instead of a long list of parameters
+*/
+struct CharacterParams
+{
+	std::string sName{ "" };
+	int health{ 0 };
+	int mana{ 0 };
+	int level{ 1 };
+	bool bIsNPC{ false };
+};
+
+// ===================================================================================
+// Method Chaining
+// ===================================================================================
+
+// Character Builder class
+class Character
+{
+private:
+	std::string sName{ "" };
+	int health{ 0 };
+	int mana{ 0 };
+	int level{ 1 };
+	bool bIsNPC{ false };
+
+	// Lets the binary serializer see the private fields, see character_serialization.hpp
+	template <typename> friend struct utils::Reflect;
+
+public:
+	Character& SetName(const std::string& name) { sName = name; return *this; }
+	Character& SetHealth(int inHealth) { health = inHealth; return *this; }
+	Character& SetMana(int inMana) { mana = inMana; return *this; }
+	Character& SetLevel(int inLevel) { level = inLevel; return *this; }
+	Character& SetAsNPC(bool npc) { bIsNPC = npc; return *this; }
+
+	const std::string& GetName() const { return sName; }
+	int GetHealth() const { return health; }
+	int GetMana() const { return mana; }
+	int GetLevel() const { return level; }
+	bool IsNPC() const { return bIsNPC; }
+
+	void Print() const {
+		std::cout << "Character " << sName 
+			<< " (Lvl " << level << ") HP: " << health << " Mana: " << mana << "\n";
+	}
+};
+
+/* 
+* Here's another example of Method chaining that does not use a build pattern.
+* Imagine we have a configuration system where we can set various options dynamically
+*/
+
+class Settings
+{
+private:
+	bool bFullscreen{ false };
+	int resolutionWidth{ 1920 };
+	int resolutionHeight{ 1080 };
+	int volume{ 50 };
+
+	template <typename> friend struct utils::Reflect;
+
+public:
+	Settings& SetFullScreenMode(bool fullscreen) { bFullscreen = fullscreen; return *this; }
+	Settings& SetResolution(int width, int height) 
+	{ 
+		resolutionWidth = width; 
+		resolutionHeight = height; 
+		return *this; 
+	}
+	Settings& SetVolume(int inVolume) 
+	{ 
+		volume = inVolume; 
+		return *this; 
+	}
+
+	void Apply() const
+	{
+		TRACE_SCOPE("Settings::Apply");
+		std::cout << "Applying Settings:\n"
+			<< "Fullscreen: " << (bFullscreen ? "Enabled" : "Disabled") << "\n"
+			<< "Resolution: " << resolutionWidth << " x " << resolutionHeight << "\n"
+			<< "Volume: " << volume << "\n";
+ 	}
+};
+
+// ===================================================================================
+// Combining Named Arguments with Method Chaining
+// ===================================================================================
+/*
+* Alright Now let's combine the two
+*/
+class CharacterBuilder
+{
+private:
+	Character character;
+
+public:
+	CharacterBuilder& name(const std::string& name) { character.SetName(name); return *this; }
+	CharacterBuilder& health(int health) { character.SetHealth(health); return *this; }
+	CharacterBuilder& mana(int mana) { character.SetMana(mana); return *this; }
+	CharacterBuilder& level(int level) { character.SetLevel(level); return *this; }
+	CharacterBuilder& npc(bool npc) { character.SetAsNPC(npc); return *this; }
+
+	Character build() { return character; }
+};
@@ -0,0 +1,303 @@
+#include "character_index.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+bool Matches(const Character& character, const CharacterFilter& filter)
+{
+	return (!filter.bIsNPC || character.IsNPC() == *filter.bIsNPC)
+		&& character.GetLevel() >= filter.minLevel && character.GetLevel() <= filter.maxLevel
+		&& character.GetHealth() >= filter.minHealth && character.GetHealth() <= filter.maxHealth;
+}
+
+// ===================================================================================
+// SortedIdColumn
+// ===================================================================================
+std::size_t SortedIdColumn::FirstBlockNotBefore(const Entry& entry) const
+{
+	const auto it = std::partition_point(m_Blocks.begin(), m_Blocks.end(),
+		[&entry](const std::vector<Entry>& block) { return block.back() < entry; });
+	return static_cast<std::size_t>(it - m_Blocks.begin());
+}
+
+void SortedIdColumn::Insert(int key, CharacterId id)
+{
+	const Entry entry{ key, id };
+	if (m_Blocks.empty())
+		m_Blocks.emplace_back();
+
+	// Past the end of every block goes at the end of the last one
+	const std::size_t b = std::min(FirstBlockNotBefore(entry), m_Blocks.size() - 1);
+	std::vector<Entry>& block = m_Blocks[b];
+	block.insert(std::lower_bound(block.begin(), block.end(), entry), entry);
+	++m_Size;
+
+	if (block.size() > kBlockSize)
+	{
+		std::vector<Entry> upperHalf(block.begin() + kBlockSize / 2, block.end());
+		block.resize(kBlockSize / 2);
+		m_Blocks.insert(m_Blocks.begin() + static_cast<std::ptrdiff_t>(b) + 1, std::move(upperHalf));
+	}
+}
+
+void SortedIdColumn::Erase(int key, CharacterId id)
+{
+	const Entry entry{ key, id };
+	const std::size_t b = FirstBlockNotBefore(entry);
+	if (b == m_Blocks.size())
+		return;
+
+	std::vector<Entry>& block = m_Blocks[b];
+	const auto it = std::lower_bound(block.begin(), block.end(), entry);
+	if (it == block.end() || *it != entry)
+		return;
+
+	block.erase(it);
+	--m_Size;
+	if (block.empty())
+		m_Blocks.erase(m_Blocks.begin() + static_cast<std::ptrdiff_t>(b));
+}
+
+void SortedIdColumn::InsertBulk(std::vector<Entry> entries)
+{
+	std::sort(entries.begin(), entries.end());
+
+	std::vector<Entry> merged;
+	merged.reserve(m_Size + entries.size());
+	for (const std::vector<Entry>& block : m_Blocks)
+		merged.insert(merged.end(), block.begin(), block.end());
+	const auto middle = merged.insert(merged.end(), entries.begin(), entries.end());
+	std::inplace_merge(merged.begin(), middle, merged.end());
+
+	// Blocks start half full, so the next inserts don't split them right away
+	m_Blocks.clear();
+	for (std::size_t i = 0; i < merged.size(); i += kBlockSize / 2)
+	{
+		const std::size_t end = std::min(i + kBlockSize / 2, merged.size());
+		m_Blocks.emplace_back(merged.begin() + static_cast<std::ptrdiff_t>(i),
+			merged.begin() + static_cast<std::ptrdiff_t>(end));
+	}
+	m_Size = merged.size();
+}
+
+std::size_t SortedIdColumn::CountRange(int minKey, int maxKey) const
+{
+	const Entry first{ minKey, 0 };
+	const Entry last{ maxKey, std::numeric_limits<CharacterId>::max() };
+
+	std::size_t count{ 0 };
+	for (std::size_t b = FirstBlockNotBefore(first); b < m_Blocks.size(); ++b)
+	{
+		const std::vector<Entry>& block = m_Blocks[b];
+		if (block.front() > last)
+			break;
+
+		// Only the blocks at either end of the range need a search
+		const auto begin = block.front() >= first ? block.begin() : std::lower_bound(block.begin(), block.end(), first);
+		const auto end = block.back() <= last ? block.end() : std::upper_bound(block.begin(), block.end(), last);
+		count += static_cast<std::size_t>(end - begin);
+	}
+	return count;
+}
+
+// ===================================================================================
+// Editor
+// ===================================================================================
+CharacterIndex::Editor& CharacterIndex::Editor::SetName(const std::string& name)
+{
+	index.m_Characters[id].SetName(name);
+	return *this;
+}
+
+CharacterIndex::Editor& CharacterIndex::Editor::SetHealth(int health)
+{
+	int& current = index.m_Health[id];
+	if (current != health)
+	{
+		index.m_HealthOrder.Erase(current, id);
+		index.m_HealthOrder.Insert(health, id);
+		current = health;
+		index.m_Characters[id].SetHealth(health);
+	}
+	return *this;
+}
+
+CharacterIndex::Editor& CharacterIndex::Editor::SetMana(int mana)
+{
+	index.m_Characters[id].SetMana(mana);
+	return *this;
+}
+
+CharacterIndex::Editor& CharacterIndex::Editor::SetLevel(int level)
+{
+	int& current = index.m_Level[id];
+	if (current != level)
+	{
+		// Drop empty levels, so a level range only ever visits levels somebody has
+		const auto it = index.m_Levels.find(current);
+		it->second.Reset(id);
+		if (it->second.Count() == 0)
+			index.m_Levels.erase(it);
+
+		index.m_Levels[level].Set(id);
+		current = level;
+		index.m_Characters[id].SetLevel(level);
+	}
+	return *this;
+}
+
+CharacterIndex::Editor& CharacterIndex::Editor::SetAsNPC(bool npc)
+{
+	if (npc)
+		index.m_Npcs.Set(id);
+	else
+		index.m_Npcs.Reset(id);
+	index.m_Characters[id].SetAsNPC(npc);
+	return *this;
+}
+
+// ===================================================================================
+// CharacterIndex
+// ===================================================================================
+CharacterId CharacterIndex::Add(Character character)
+{
+	if (m_Characters.size() >= std::numeric_limits<CharacterId>::max())
+		throw std::length_error("CharacterIndex is full");
+
+	const auto id = static_cast<CharacterId>(m_Characters.size());
+	m_Health.push_back(character.GetHealth());
+	m_Level.push_back(character.GetLevel());
+	m_Levels[character.GetLevel()].Set(id);
+	if (character.IsNPC())
+		m_Npcs.Set(id);
+	m_HealthOrder.Insert(character.GetHealth(), id);
+	m_Characters.push_back(std::move(character));
+	return id;
+}
+
+void CharacterIndex::Add(std::span<const Character> characters)
+{
+	if (characters.size() >= std::numeric_limits<CharacterId>::max() - m_Characters.size())
+		throw std::length_error("CharacterIndex is full");
+
+	const auto firstId = static_cast<CharacterId>(m_Characters.size());
+	m_Characters.insert(m_Characters.end(), characters.begin(), characters.end());
+	m_Health.reserve(m_Characters.size());
+	m_Level.reserve(m_Characters.size());
+
+	std::vector<SortedIdColumn::Entry> byHealth;
+	byHealth.reserve(characters.size());
+	for (CharacterId id = firstId; id < m_Characters.size(); ++id)
+	{
+		const Character& character = m_Characters[id];
+		m_Health.push_back(character.GetHealth());
+		m_Level.push_back(character.GetLevel());
+		m_Levels[character.GetLevel()].Set(id);
+		if (character.IsNPC())
+			m_Npcs.Set(id);
+		byHealth.emplace_back(character.GetHealth(), id);
+	}
+
+	m_HealthOrder.InsertBulk(std::move(byHealth));
+}
+
+bool CharacterIndex::MatchesColumns(CharacterId id, const CharacterFilter& filter) const
+{
+	return (!filter.bIsNPC || m_Npcs.Test(id) == *filter.bIsNPC)
+		&& m_Level[id] >= filter.minLevel && m_Level[id] <= filter.maxLevel
+		&& m_Health[id] >= filter.minHealth && m_Health[id] <= filter.maxHealth;
+}
+
+std::vector<CharacterId> CharacterIndex::Find(const CharacterFilter& filter) const
+{
+	std::vector<CharacterId> ids;
+	if (filter.minLevel > filter.maxLevel || filter.minHealth > filter.maxHealth)
+		return ids;
+
+	const auto levelBegin = m_Levels.lower_bound(filter.minLevel);
+	const auto levelEnd = m_Levels.upper_bound(filter.maxLevel);
+
+	// Exact candidate counts for the bitmap indexes, they keep their own
+	std::size_t levelCandidates{ 0 };
+	for (auto it = levelBegin; it != levelEnd; ++it)
+		levelCandidates += it->second.Count();
+	if (levelCandidates == 0)
+		return ids;
+
+	std::size_t npcCandidates{ m_Characters.size() };
+	if (filter.bIsNPC)
+		npcCandidates = *filter.bIsNPC ? m_Npcs.Count() : m_Characters.size() - m_Npcs.Count();
+
+	/*
+	* Start from the health column when its range is clearly the smallest. A candidate
+	* from it costs a random lookup in the other columns, while the bitmaps handle
+	* 64 characters per word, hence the kColumnCost handicap.
+	*/
+	constexpr std::size_t kColumnCost{ 4 };
+	if (filter.FiltersHealth()
+		&& m_HealthOrder.CountRange(filter.minHealth, filter.maxHealth) * kColumnCost <= std::min(levelCandidates, npcCandidates))
+	{
+		FindByHealth(filter, ids);
+		return ids;
+	}
+
+	FindByBitmaps(filter, levelBegin, levelEnd, ids);
+	return ids;
+}
+
+void CharacterIndex::FindByHealth(const CharacterFilter& filter, std::vector<CharacterId>& outIds) const
+{
+	// The column is in health order, a bitmap puts the matches back in id order without a sort
+	std::vector<std::uint64_t> matches((m_Characters.size() + 63) / 64, 0);
+	m_HealthOrder.ForEachInRange(filter.minHealth, filter.maxHealth,
+		[&](CharacterId id)
+		{
+			if (MatchesColumns(id, filter))
+				matches[id / 64] |= std::uint64_t{ 1 } << (id % 64);
+		});
+
+	for (std::size_t i = 0; i < matches.size(); ++i)
+	{
+		for (std::uint64_t word = matches[i]; word != 0; word &= word - 1)
+			outIds.push_back(static_cast<CharacterId>(i * 64 + static_cast<std::size_t>(std::countr_zero(word))));
+	}
+}
+
+void CharacterIndex::FindByBitmaps(const CharacterFilter& filter, LevelMap::const_iterator levelBegin,
+	LevelMap::const_iterator levelEnd, std::vector<CharacterId>& outIds) const
+{
+	std::vector<std::uint64_t> candidates((m_Characters.size() + 63) / 64, 0);
+	if (!filter.FiltersLevel())
+	{
+		// Every character, no need to OR every level together
+		std::fill(candidates.begin(), candidates.end(), ~std::uint64_t{ 0 });
+		if (const std::size_t tail = m_Characters.size() % 64; tail != 0)
+			candidates.back() = (std::uint64_t{ 1 } << tail) - 1;
+	}
+	else
+	{
+		// OR the level bitmaps together one at a time, each is a straight pass over its words
+		for (auto it = levelBegin; it != levelEnd; ++it)
+		{
+			const std::span<const std::uint64_t> words = it->second.Words();
+			for (std::size_t i = 0; i < words.size(); ++i)
+				candidates[i] |= words[i];
+		}
+	}
+
+	const bool bCheckHealth = filter.FiltersHealth();
+	for (std::size_t i = 0; i < candidates.size(); ++i)
+	{
+		std::uint64_t word = candidates[i];
+		if (filter.bIsNPC)
+			word &= *filter.bIsNPC ? m_Npcs.Word(i) : ~m_Npcs.Word(i);
+
+		while (word != 0)
+		{
+			const auto id = static_cast<CharacterId>(i * 64 + static_cast<std::size_t>(std::countr_zero(word)));
+			word &= word - 1;
+			if (!bCheckHealth || (m_Health[id] >= filter.minHealth && m_Health[id] <= filter.maxHealth))
+				outIds.push_back(id);
+		}
+	}
+}
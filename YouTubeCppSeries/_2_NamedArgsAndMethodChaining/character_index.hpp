@@ -0,0 +1,195 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "NamedArgsAndMethodChaining.hpp"
+
+// ===================================================================================
+// Finding Characters
+// ===================================================================================
+using CharacterId = std::uint32_t;
+
+/*
+* What to look for, named arguments style. Leave a field alone to not filter on it.
+* Ranges are inclusive: "NPCs with level 5-10 and health under 50" is
+*	{ .bIsNPC = true, .minLevel = 5, .maxLevel = 10, .maxHealth = 49 }
+*/
+struct CharacterFilter
+{
+	std::optional<bool> bIsNPC{};
+	int minLevel{ std::numeric_limits<int>::min() };
+	int maxLevel{ std::numeric_limits<int>::max() };
+	int minHealth{ std::numeric_limits<int>::min() };
+	int maxHealth{ std::numeric_limits<int>::max() };
+
+	bool FiltersLevel() const
+	{
+		return minLevel != std::numeric_limits<int>::min() || maxLevel != std::numeric_limits<int>::max();
+	}
+	bool FiltersHealth() const
+	{
+		return minHealth != std::numeric_limits<int>::min() || maxHealth != std::numeric_limits<int>::max();
+	}
+};
+
+/* The plain linear check, what the index saves you from running on every character. */
+bool Matches(const Character& character, const CharacterFilter& filter);
+
+/* A growable set of bits, one per CharacterId. */
+class CharacterBitmap
+{
+public:
+	void Set(CharacterId id)
+	{
+		const std::size_t word = id / 64;
+		if (word >= m_Words.size())
+			m_Words.resize(word + 1, 0);
+		const std::uint64_t bit = std::uint64_t{ 1 } << (id % 64);
+		m_Count += (m_Words[word] & bit) == 0;
+		m_Words[word] |= bit;
+	}
+
+	void Reset(CharacterId id)
+	{
+		const std::size_t word = id / 64;
+		if (word >= m_Words.size())
+			return;
+		const std::uint64_t bit = std::uint64_t{ 1 } << (id % 64);
+		m_Count -= (m_Words[word] & bit) != 0;
+		m_Words[word] &= ~bit;
+	}
+
+	bool Test(CharacterId id) const
+	{
+		const std::size_t word = id / 64;
+		return word < m_Words.size() && (m_Words[word] >> (id % 64)) & 1;
+	}
+
+	/* Word i, or 0 past the end (bitmaps only grow as far as their highest set bit). */
+	std::uint64_t Word(std::size_t i) const { return i < m_Words.size() ? m_Words[i] : 0; }
+	std::span<const std::uint64_t> Words() const { return m_Words; }
+	std::size_t Count() const { return m_Count; }
+
+private:
+	std::vector<std::uint64_t> m_Words;
+	std::size_t m_Count{ 0 };
+};
+
+/*
+* (key, id) pairs kept sorted, as a list of small sorted blocks.
+* - Walking a range is mostly sequential memory, unlike hopping between tree nodes.
+* - Insert/Erase only shift one block (at most kBlockSize entries).
+* - Counting a range costs one step per block, so a query can ask how big
+* a range is before deciding to walk it.
+*/
+class SortedIdColumn
+{
+public:
+	using Entry = std::pair<int, CharacterId>;
+	static constexpr std::size_t kBlockSize{ 512 };
+
+	void Insert(int key, CharacterId id);
+	void Erase(int key, CharacterId id);
+
+	/* Adds many entries at once, cheaper than inserting them one by one. */
+	void InsertBulk(std::vector<Entry> entries);
+
+	/* Entries with minKey <= key <= maxKey. */
+	std::size_t CountRange(int minKey, int maxKey) const;
+
+	template <typename Func>
+	void ForEachInRange(int minKey, int maxKey, Func&& func) const
+	{
+		const Entry first{ minKey, 0 };
+		const Entry last{ maxKey, std::numeric_limits<CharacterId>::max() };
+		for (std::size_t b = FirstBlockNotBefore(first); b < m_Blocks.size(); ++b)
+		{
+			const std::vector<Entry>& block = m_Blocks[b];
+			if (block.front() > last)
+				return;
+			for (auto it = std::lower_bound(block.begin(), block.end(), first); it != block.end() && *it <= last; ++it)
+				func(it->second);
+		}
+	}
+
+	std::size_t Size() const { return m_Size; }
+
+private:
+	/* First block whose last entry is >= entry. */
+	std::size_t FirstBlockNotBefore(const Entry& entry) const;
+
+	std::vector<std::vector<Entry>> m_Blocks;	// Each sorted and non-empty, in order
+	std::size_t m_Size{ 0 };
+};
+
+/*
+* CharacterIndex
+* - Owns the characters and keeps secondary indexes over them:
+*	level  -> one bitmap per level (ordered, so a level range is a handful of bitmaps)
+*	NPC    -> one bitmap
+*	health -> a sorted column of (health, id), so a health range is one contiguous walk
+* - Find() starts from whichever index gives the fewest candidates and checks the
+* other conditions against flat columns, instead of scanning every character.
+* - Changes go through Edit(), whose setters chain like Character's and update
+* the indexes right away (O(log N) per indexed field).
+* - Not thread-safe, guard it like any other container.
+*/
+class CharacterIndex
+{
+public:
+	class Editor
+	{
+	public:
+		Editor& SetName(const std::string& name);
+		Editor& SetHealth(int health);
+		Editor& SetMana(int mana);
+		Editor& SetLevel(int level);
+		Editor& SetAsNPC(bool npc);
+
+	private:
+		friend class CharacterIndex;
+		Editor(CharacterIndex& inIndex, CharacterId inId) : index{ inIndex }, id{ inId } {}
+
+		CharacterIndex& index;
+		CharacterId id;
+	};
+
+	CharacterId Add(Character character);
+
+	/* Bulk load, sorts the health index once instead of inserting one at a time. */
+	void Add(std::span<const Character> characters);
+
+	Editor Edit(CharacterId id) { return Editor{ *this, id }; }
+	const Character& Get(CharacterId id) const { return m_Characters[id]; }
+	std::size_t Size() const { return m_Characters.size(); }
+
+	/* Ids of every character matching 'filter', ascending. */
+	std::vector<CharacterId> Find(const CharacterFilter& filter) const;
+
+private:
+	using LevelMap = std::map<int, CharacterBitmap>;
+
+	bool MatchesColumns(CharacterId id, const CharacterFilter& filter) const;
+	void FindByHealth(const CharacterFilter& filter, std::vector<CharacterId>& outIds) const;
+	void FindByBitmaps(const CharacterFilter& filter, LevelMap::const_iterator levelBegin,
+		LevelMap::const_iterator levelEnd, std::vector<CharacterId>& outIds) const;
+
+	std::vector<Character> m_Characters;
+
+	// Columns, so checking a candidate doesn't touch the whole Character
+	std::vector<int> m_Health;
+	std::vector<int> m_Level;
+
+	LevelMap m_Levels;
+	CharacterBitmap m_Npcs;
+	SortedIdColumn m_HealthOrder;
+};
@@ -0,0 +1,51 @@
+#pragma once
+#include <tuple>
+
+#include "NamedArgsAndMethodChaining.hpp"
+#include "../Utilities/binary_serialization.hpp"
+
+// ===================================================================================
+// Saving Characters
+// ===================================================================================
+/*
+* The field lists the binary serializer walks. To change a type's layout,
+* append new fields at the end and bump its version, never reorder or remove:
+* old snapshots must still load.
+*/
+template <>
+struct utils::Reflect<CharacterParams>
+{
+	static constexpr std::uint16_t version{ 1 };
+	static constexpr std::tuple fields{
+		Field{ "sName", &CharacterParams::sName },
+		Field{ "health", &CharacterParams::health },
+		Field{ "mana", &CharacterParams::mana },
+		Field{ "level", &CharacterParams::level },
+		Field{ "bIsNPC", &CharacterParams::bIsNPC },
+	};
+};
+
+template <>
+struct utils::Reflect<Character>
+{
+	static constexpr std::uint16_t version{ 1 };
+	static constexpr std::tuple fields{
+		Field{ "sName", &Character::sName },
+		Field{ "health", &Character::health },
+		Field{ "mana", &Character::mana },
+		Field{ "level", &Character::level },
+		Field{ "bIsNPC", &Character::bIsNPC },
+	};
+};
+
+template <>
+struct utils::Reflect<Settings>
+{
+	static constexpr std::uint16_t version{ 1 };
+	static constexpr std::tuple fields{
+		Field{ "bFullscreen", &Settings::bFullscreen },
+		Field{ "resolutionWidth", &Settings::resolutionWidth },
+		Field{ "resolutionHeight", &Settings::resolutionHeight },
+		Field{ "volume", &Settings::volume },
+	};
+};
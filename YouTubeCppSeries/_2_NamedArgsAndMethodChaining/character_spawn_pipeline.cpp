@@ -0,0 +1,433 @@
+#include "character_spawn_pipeline.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include <fmt/format.h>
+
+#include "../Utilities/cycle_clock.hpp"
+#include "../Utilities/spsc_queue.hpp"
+#include "../Utilities/thread_pool.hpp"
+#include "../Utilities/tracing.hpp"
+
+namespace
+{
+	using ParamsBatch = std::vector<CharacterParams>;
+	using CharacterBatch = std::vector<Character>;
+
+	/*
+	* The first exception thrown by any stage. Once something failed, the stages
+	* stop working but keep draining their queues, so nobody blocks forever on a full one.
+	*/
+	struct StageErrors
+	{
+		std::atomic<bool> bFailed{ false };
+		std::mutex mutex;
+		std::exception_ptr pError{ nullptr };
+
+		void Record()
+		{
+			std::lock_guard lock{ mutex };
+			if (!pError)
+				pError = std::current_exception();
+			bFailed.store(true, std::memory_order_release);
+		}
+
+		bool Failed() const { return bFailed.load(std::memory_order_acquire); }
+	};
+
+	double TicksToSeconds(std::uint64_t ticks)
+	{
+		return static_cast<double>(utils::CycleClock::ToNanoseconds(ticks)) * 1e-9;
+	}
+
+	/* Small batches stay on the stage's own thread, big ones are split over the pool. */
+	template <typename Func>
+	void ForEachIndex(utils::ThreadPool& pool, std::size_t count, std::size_t parallelThreshold, Func&& func)
+	{
+		if (count >= parallelThreshold && pool.Size() > 1)
+		{
+			pool.ParallelFor(std::size_t{ 0 }, count, func);
+			return;
+		}
+
+		for (std::size_t i = 0; i < count; ++i)
+			func(i);
+	}
+
+	template <typename Result>
+	std::size_t ItemCount(const Result& result)
+	{
+		if constexpr (std::is_integral_v<Result>)
+			return static_cast<std::size_t>(result);
+		else
+			return result.size();
+	}
+
+	/*
+	* The loop every stage after Parse runs.
+	* - work(batch) turns one input batch into a result, this is the busy time.
+	* - emit(result) hands it on (usually a Push() that may block, so it isn't timed).
+	*/
+	template <typename In, typename Work, typename Emit>
+	void RunStage(const char* pTraceName, utils::SpscQueue<In>& input, SpawnStageStats& stats,
+		StageErrors& errors, Work&& work, Emit&& emit)
+	{
+		std::uint64_t busyTicks{ 0 };
+		std::uint64_t depthSum{ 0 };
+
+		while (std::optional<In> batch = input.Pop())
+		{
+			// The batch we just took was waiting too
+			const std::size_t depth = input.Size() + 1;
+			stats.maxQueueDepth = std::max(stats.maxQueueDepth, depth);
+			depthSum += depth;
+			++stats.batches;
+
+			if (errors.Failed())
+				continue;
+
+			try
+			{
+				const std::uint64_t begin = utils::CycleClock::Now();
+				auto result = [&]
+				{
+					TRACE_SCOPE(pTraceName);
+					return work(std::move(*batch));
+				}();
+				busyTicks += utils::CycleClock::Now() - begin;
+
+				stats.items += ItemCount(result);
+				emit(std::move(result));
+			}
+			catch (...)
+			{
+				errors.Record();
+			}
+		}
+
+		stats.busySeconds = TicksToSeconds(busyTicks);
+		if (stats.batches > 0)
+			stats.avgQueueDepth = static_cast<double>(depthSum) / static_cast<double>(stats.batches);
+	}
+
+	std::string_view Trim(std::string_view text)
+	{
+		constexpr std::string_view kWhitespace{ " \t\r\n" };
+		const std::size_t first = text.find_first_not_of(kWhitespace);
+		if (first == std::string_view::npos)
+			return {};
+		return text.substr(first, text.find_last_not_of(kWhitespace) - first + 1);
+	}
+
+	bool ParseInt(std::string_view text, int& outValue)
+	{
+		text = Trim(text);
+		const auto [pEnd, error] = std::from_chars(text.data(), text.data() + text.size(), outValue);
+		return error == std::errc{} && pEnd == text.data() + text.size();
+	}
+
+	bool ParseBool(std::string_view text, bool& outValue)
+	{
+		text = Trim(text);
+		if (text == "1" || text == "true")
+			outValue = true;
+		else if (text == "0" || text == "false")
+			outValue = false;
+		else
+			return false;
+		return true;
+	}
+
+	/* name,health,mana,level,npc -> params. False if the line doesn't look like that. */
+	bool ParseCsvLine(std::string_view line, CharacterParams& outParams)
+	{
+		std::array<std::string_view, 5> fields{};
+		std::size_t fieldCount{ 0 };
+		for (;;)
+		{
+			const std::size_t comma = line.find(',');
+			if (fieldCount == fields.size())
+				return false;
+			fields[fieldCount++] = line.substr(0, comma);
+			if (comma == std::string_view::npos)
+				break;
+			line.remove_prefix(comma + 1);
+		}
+
+		if (fieldCount != fields.size())
+			return false;
+
+		outParams.sName = std::string{ Trim(fields[0]) };
+		return ParseInt(fields[1], outParams.health)
+			&& ParseInt(fields[2], outParams.mana)
+			&& ParseInt(fields[3], outParams.level)
+			&& ParseBool(fields[4], outParams.bIsNPC);
+	}
+
+	/*
+	* Sources fill the next batch for the parse stage and return false once
+	* there is nothing left.
+	*/
+	class CsvSource
+	{
+	public:
+		explicit CsvSource(std::istream& inCsv) : csv{ inCsv } {}
+
+		bool operator()(ParamsBatch& batch, std::size_t batchSize, std::uint64_t& malformed)
+		{
+			while (batch.size() < batchSize)
+			{
+				if (!std::getline(csv, sLine))
+					return false;
+
+				const std::string_view line = Trim(sLine);
+				if (line.empty() || line.front() == '#')
+					continue;
+
+				// Optional header on the first line
+				if (bFirstLine && line.starts_with("name,"))
+				{
+					bFirstLine = false;
+					continue;
+				}
+				bFirstLine = false;
+
+				CharacterParams params{};
+				if (ParseCsvLine(line, params))
+					batch.push_back(std::move(params));
+				else
+					++malformed;
+			}
+			return true;
+		}
+
+	private:
+		std::istream& csv;
+		std::string sLine;
+		bool bFirstLine{ true };
+	};
+
+	class SpanSource
+	{
+	public:
+		explicit SpanSource(std::span<const CharacterParams> inParams) : params{ inParams } {}
+
+		bool operator()(ParamsBatch& batch, std::size_t batchSize, std::uint64_t&)
+		{
+			const std::size_t count = std::min(batchSize, params.size());
+			batch.assign(params.begin(), params.begin() + count);
+			params = params.subspan(count);
+			return !params.empty();
+		}
+
+	private:
+		std::span<const CharacterParams> params;
+	};
+}
+
+std::string_view ValidateCharacter(const CharacterParams& params)
+{
+	if (params.sName.empty())
+		return "name is empty";
+	if (params.sName.size() > CharacterLimits::kMaxNameLength)
+		return "name is too long";
+	if (params.health <= 0 || params.health > CharacterLimits::kMaxHealth)
+		return "health out of range";
+	if (params.mana < 0 || params.mana > CharacterLimits::kMaxMana)
+		return "mana out of range";
+	if (params.level < CharacterLimits::kMinLevel || params.level > CharacterLimits::kMaxLevel)
+		return "level out of range";
+	return {};
+}
+
+void SpawnReport::Print(std::FILE* pOut) const
+{
+	fmt::print(pOut, "{:<10} {:>10} {:>8} {:>10} {:>7} {:>14} {:>10} {:>10}\n",
+		"Stage", "Items", "Batches", "Busy", "Busy%", "Items/busy s", "Queue avg", "Queue max");
+
+	for (const SpawnStageStats& stage : stages)
+	{
+		/*
+		* Per busy second, not per wall second: every stage sees the same items over
+		* the same wall time, so that would print one number four times. This is
+		* how fast the stage would go if it never waited, the slowest one is the limit.
+		*/
+		const double busyPercent = seconds > 0.0 ? stage.busySeconds / seconds * 100.0 : 0.0;
+		const double perBusySecond = stage.busySeconds > 0.0 ? static_cast<double>(stage.items) / stage.busySeconds : 0.0;
+		fmt::print(pOut, "{:<10} {:>10} {:>8} {:>8.2f}ms {:>6.1f}% {:>14.0f} {:>10.2f} {:>10}\n",
+			stage.pName, stage.items, stage.batches, stage.busySeconds * 1e3, busyPercent,
+			perBusySecond, stage.avgQueueDepth, stage.maxQueueDepth);
+	}
+
+	const double perSecond = seconds > 0.0 ? static_cast<double>(spawned) / seconds : 0.0;
+	fmt::print(pOut, "Spawned {} characters in {:.2f}ms, {:.0f}/s wall ({} rejected, {} malformed)\n",
+		spawned, seconds * 1e3, perSecond, rejected, malformed);
+}
+
+CharacterSpawnPipeline::CharacterSpawnPipeline(const SpawnPipelineConfig& config)
+	: m_Config{ config }
+{
+	m_Config.batchSize = std::max<std::size_t>(m_Config.batchSize, 1);
+	m_Config.queueCapacity = std::max<std::size_t>(m_Config.queueCapacity, 1);
+
+	// Full batches always use the pool, and so does a last partial batch of at least half the size
+	if (m_Config.parallelThreshold == 0)
+		m_Config.parallelThreshold = std::max<std::size_t>(m_Config.batchSize / 2, 1);
+}
+
+SpawnReport CharacterSpawnPipeline::Run(std::istream& csv, std::vector<Character>& storage)
+{
+	return RunStages(CsvSource{ csv }, storage);
+}
+
+SpawnReport CharacterSpawnPipeline::Run(std::span<const CharacterParams> params, std::vector<Character>& storage)
+{
+	storage.reserve(storage.size() + params.size());
+	return RunStages(SpanSource{ params }, storage);
+}
+
+template <typename Source>
+SpawnReport CharacterSpawnPipeline::RunStages(Source&& source, std::vector<Character>& storage)
+{
+	utils::ThreadPool& pool = m_Config.pPool ? *m_Config.pPool : utils::DefaultThreadPool();
+	const std::size_t batchSize = m_Config.batchSize;
+	const std::size_t parallelThreshold = m_Config.parallelThreshold;
+
+	utils::SpscQueue<ParamsBatch> parsed{ m_Config.queueCapacity };
+	utils::SpscQueue<ParamsBatch> validated{ m_Config.queueCapacity };
+	utils::SpscQueue<CharacterBatch> built{ m_Config.queueCapacity };
+
+	SpawnReport report{};
+	report.stages[SpawnReport::Parse].pName = "Parse";
+	report.stages[SpawnReport::Validate].pName = "Validate";
+	report.stages[SpawnReport::Build].pName = "Build";
+	report.stages[SpawnReport::Commit].pName = "Commit";
+
+	StageErrors errors{};
+	const auto start = std::chrono::steady_clock::now();
+
+	// Parse: source -> batches of params
+	std::thread parseThread{ [&]
+		{
+			SpawnStageStats& stats = report.stages[SpawnReport::Parse];
+			std::uint64_t busyTicks{ 0 };
+			try
+			{
+				for (bool bMore = true; bMore && !errors.Failed();)
+				{
+					ParamsBatch batch;
+					batch.reserve(batchSize);
+
+					const std::uint64_t begin = utils::CycleClock::Now();
+					{
+						TRACE_SCOPE("SpawnPipeline::Parse");
+						bMore = source(batch, batchSize, report.malformed);
+					}
+					busyTicks += utils::CycleClock::Now() - begin;
+
+					if (batch.empty())
+						continue;
+					stats.items += batch.size();
+					++stats.batches;
+					parsed.Push(std::move(batch));
+				}
+			}
+			catch (...)
+			{
+				errors.Record();
+			}
+			stats.busySeconds = TicksToSeconds(busyTicks);
+			parsed.Close();
+		} };
+
+	// Validate: drop anything out of range, keep the order of the rest
+	std::thread validateThread{ [&]
+		{
+			RunStage("SpawnPipeline::Validate", parsed, report.stages[SpawnReport::Validate], errors,
+				[&](ParamsBatch&& batch)
+				{
+					std::vector<std::uint8_t> valid(batch.size());
+					ForEachIndex(pool, batch.size(), parallelThreshold,
+						[&](std::size_t i) { valid[i] = ValidateCharacter(batch[i]).empty(); });
+
+					std::size_t kept{ 0 };
+					for (std::size_t i = 0; i < batch.size(); ++i)
+					{
+						if (!valid[i])
+							continue;
+						if (kept != i)
+							batch[kept] = std::move(batch[i]);
+						++kept;
+					}
+					report.rejected += batch.size() - kept;
+					batch.erase(batch.begin() + static_cast<std::ptrdiff_t>(kept), batch.end());
+					return std::move(batch);
+				},
+				[&](ParamsBatch&& batch)
+				{
+					if (!batch.empty())
+						validated.Push(std::move(batch));
+				});
+			validated.Close();
+		} };
+
+	// Build: params -> characters, through the same builder as everywhere else
+	std::thread buildThread{ [&]
+		{
+			RunStage("SpawnPipeline::Build", validated, report.stages[SpawnReport::Build], errors,
+				[&](ParamsBatch&& batch)
+				{
+					CharacterBatch characters(batch.size());
+					ForEachIndex(pool, batch.size(), parallelThreshold,
+						[&](std::size_t i)
+						{
+							const CharacterParams& params = batch[i];
+							characters[i] = CharacterBuilder()
+								.name(params.sName)
+								.health(params.health)
+								.mana(params.mana)
+								.level(params.level)
+								.npc(params.bIsNPC)
+								.build();
+						});
+					return characters;
+				},
+				[&](CharacterBatch&& characters) { built.Push(std::move(characters)); });
+			built.Close();
+		} };
+
+	// Commit: the only stage that touches storage, so it needs no lock
+	std::thread commitThread{ [&]
+		{
+			RunStage("SpawnPipeline::Commit", built, report.stages[SpawnReport::Commit], errors,
+				[&](CharacterBatch&& characters)
+				{
+					storage.insert(storage.end(),
+						std::make_move_iterator(characters.begin()), std::make_move_iterator(characters.end()));
+					return characters.size();
+				},
+				[](std::size_t) {});
+		} };
+
+	parseThread.join();
+	validateThread.join();
+	buildThread.join();
+	commitThread.join();
+
+	report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	report.spawned = report.stages[SpawnReport::Commit].items;
+
+	if (errors.pError)
+		std::rethrow_exception(errors.pError);
+	return report;
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <istream>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "NamedArgsAndMethodChaining.hpp"
+
+namespace utils
+{
+	class ThreadPool;
+}
+
+// ===================================================================================
+// Spawning Characters in bulk
+// ===================================================================================
+/*
+* CreateCharacter(params) makes one character at a time on one thread.
+* Spawning a wave of thousands works better as a pipeline:
+*
+*	Parse -> Validate -> Build -> Commit
+*
+* - Every stage runs on its own thread and hands batches to the next one
+* through a bounded SPSC queue, so all four stages work at the same time.
+* - A full queue blocks the stage feeding it (backpressure), so a fast parser
+* can't bury a slow builder in memory.
+* - Validate and Build also split big batches over a ThreadPool, so a
+* large wave uses every core, not just four.
+*/
+
+/* Limits a spawned character has to respect. */
+struct CharacterLimits
+{
+	static constexpr std::size_t kMaxNameLength{ 32 };
+	static constexpr int kMaxHealth{ 100'000 };
+	static constexpr int kMaxMana{ 100'000 };
+	static constexpr int kMinLevel{ 1 };
+	static constexpr int kMaxLevel{ 100 };
+};
+
+/* Empty when the params are fine, otherwise why they were rejected. */
+std::string_view ValidateCharacter(const CharacterParams& params);
+
+struct SpawnPipelineConfig
+{
+	std::size_t batchSize{ 1024 };				// Characters per batch handed between stages
+	std::size_t queueCapacity{ 8 };				// Batches each queue holds before backpressure kicks in
+	std::size_t parallelThreshold{ 0 };			// Batches at least this big are split over the pool, 0 = half a batch
+	utils::ThreadPool* pPool{ nullptr };		// nullptr = utils::DefaultThreadPool()
+};
+
+/* What one stage did during a run. */
+struct SpawnStageStats
+{
+	const char* pName{ "" };
+	std::uint64_t items{ 0 };			// Characters that came out of this stage
+	std::uint64_t batches{ 0 };
+	double busySeconds{ 0.0 };			// Time spent working, not waiting on a queue
+	std::size_t maxQueueDepth{ 0 };		// Batches waiting in front of this stage
+	double avgQueueDepth{ 0.0 };		// Sampled every time the stage takes a batch
+};
+
+struct SpawnReport
+{
+	enum Stage { Parse, Validate, Build, Commit, StageCount };
+
+	std::array<SpawnStageStats, StageCount> stages{};
+	std::uint64_t spawned{ 0 };
+	std::uint64_t rejected{ 0 };		// Failed ValidateCharacter
+	std::uint64_t malformed{ 0 };		// CSV lines that could not be parsed
+	double seconds{ 0.0 };				// Wall time of the whole run
+
+	/* Per stage: items per busy second. Overall: characters per wall second. */
+	void Print(std::FILE* pOut = stdout) const;
+};
+
+class CharacterSpawnPipeline
+{
+public:
+	explicit CharacterSpawnPipeline(const SpawnPipelineConfig& config = {});
+
+	/*
+	* One character per line: name,health,mana,level,npc
+	* Empty lines, lines starting with '#' and a "name,..." header are skipped.
+	* npc is 0/1 or false/true.
+	*/
+	SpawnReport Run(std::istream& csv, std::vector<Character>& storage);
+
+	/* Already parsed params. The parse stage only cuts them into batches. */
+	SpawnReport Run(std::span<const CharacterParams> params, std::vector<Character>& storage);
+
+private:
+	template <typename Source>
+	SpawnReport RunStages(Source&& source, std::vector<Character>& storage);
+
+	SpawnPipelineConfig m_Config;
+};
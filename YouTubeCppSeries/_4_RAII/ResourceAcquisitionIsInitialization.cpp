@@ -1,10 +1,13 @@
 #include <iostream>
 #include <fstream>
 #include <memory>
-#include <thread>
 #include <mutex>
+#include <future>
 #include <fmt/format.h>
 
+#include "../Utilities/lock_profiler.hpp"
+#include "../Utilities/thread_pool.hpp"
+
 /*
 * RAII or Resource Acquisition Is Initialization, is a fundemental technique
 * that makes memory management, file handling, and even thread management safer
@@ -55,7 +58,7 @@ void RAIIFileHandlerTest()
 	}
 	catch (const std::exception& ex)
 	{
-		fmt::report_error(ex.what());
+		fmt::print(stderr, "Error: {}\n", ex.what());
 	}
 }
 
@@ -78,7 +81,11 @@ void RAIIUseUniqueResource()
 	fmt::print("Using Resource...\n");
 } // Resouce should be automatically released.
 
-std::mutex gMtx;
+/*
+* A ProfiledMutex is still just a mutex to lock_guard, but it keeps track of
+* how long threads waited for it and how long they held it.
+*/
+utils::ProfiledMutex gMtx{ "gMtx" };
 
 void ThreadSafeFunction()
 {
@@ -127,11 +134,16 @@ int main()
 	RAIIFileHandlerTest();
 	RAIIUseUniqueResource();
 	
-	std::thread t1{ ThreadSafeFunction };
-	std::thread t2{ ThreadSafeFunction };
+	// Run it from two pool threads at once. The futures tell us when both are done.
+	utils::ThreadPool pool{ 2 };
+	auto first = pool.Submit(ThreadSafeFunction);
+	auto second = pool.Submit(ThreadSafeFunction);
+
+	first.get();
+	second.get();
 
-	t1.join();
-	t2.join();
+	// Who waited on which lock, and for how long?
+	utils::LockProfiler::Report();
 
 	//while(true)
 	//{
@@ -1,36 +1,15 @@
-#include <memory>
-#include <mutex>
-#include <vector>
+#include <string>
 #include <thread>
-#include <iostream>
+#include <vector>
 
-#include <fmt/format.h>
+#include "SingletonPatternAlternatives.hpp"
+#include "../Utilities/coro_runtime.hpp"
+#include "../Utilities/thread_pool.hpp"
 
 /*
-* Singleton Pattern
-* - Ensures only one instance of a class exists
-* - Global acces to that instance
+* The Singleton, MonoLogger, DILogger, Service and ServiceLocator classes
+* live in SingletonPatternAlternatives.hpp so they can be reused and benchmarked.
 */
-class Logger
-{
-public:
-	static Logger& GetInstance()
-	{
-		static Logger instance;
-		return instance;
-	}
-
-	void Log(const std::string& message)
-	{
-		fmt::print("[LOG]: {}\n", message);
-	}
-
-private:
-	Logger() = default;
-	~Logger() = default;
-	Logger(const Logger&) = delete;
-	Logger& operator=(const Logger&) = delete;
-};
 
 void RunSingletonLogger()
 {
@@ -44,35 +23,6 @@ void RunSingletonLogger()
 * - Tight coupling
 */
 
-/*
-* The Monostate Pattern
-* 
-* - Looks like a regular class, but under the hood, it shares state between instances
-* - Here, every logger object shares the same state. But unlike singletons, Monostate
-* can be copied and moved.
-* 
-* Pros:
-* - Easier to test 
-* - Still a single global state
-* - No need for GetInstance()
-* 
-* Cons:
-* - Still hidden dependencies
-* - Global state is still global
-*/
-class MonoLogger
-{
-public:
-	void Log(const std::string& message)
-	{
-		std::lock_guard lock{ mutex };
-		fmt::print("[LOG]: {}\n", message);
-	}
-private:
-	// Shared state
-	inline static std::mutex mutex;
-};
-
 void RunMonostateLogger()
 {
 	MonoLogger log1{};
@@ -80,6 +30,9 @@ void RunMonostateLogger()
 
 	MonoLogger log2{};
 	log2.Log("MonoLogger 2 used.");
+
+	// Either instance can Sync(), they share the same buffers
+	log1.Sync();
 }
 
 void RunMonoFromThread(int threadIndex)
@@ -88,7 +41,7 @@ void RunMonoFromThread(int threadIndex)
 
 	for (int i = 0; i < 5; ++i)
 	{
-		logger.Log(fmt::format("Message: {} from thread {}", i, threadIndex));
+		logger.Log("Message: {} from thread {}", i, threadIndex);
 		std::this_thread::sleep_for(std::chrono::milliseconds(100));
 	}
 }
@@ -97,113 +50,78 @@ void CreateMonoThreads()
 {
 	constexpr int threadCount = 4;
 
-	std::vector<std::thread> threads;
-
-	for (int i = 0; i < threadCount; ++i)
-	{
-		threads.emplace_back(RunMonoFromThread, i);
-	}
-
-	for (auto& t : threads)
-	{
-		t.join();
-	}
+	// Each index runs as its own task on one of the pool's threads
+	utils::ThreadPool pool{ threadCount };
+	pool.ParallelFor(0, threadCount, RunMonoFromThread, 1);
+	MonoLogger{}.Sync();
 }
 
 /*
-* Dependency Injection
-* We can pass in any dependencies that we need.
-* Pros:
-* - Testable(Pass a fake logger)
-* - No global state!
-* - More control
-* 
-* Cons:
-* - More boilerplate
-* - You have to pass dependencies manually.
-* 
+* Same thing, but as coroutines.
+* - co_await Sleep() parks the coroutine instead of blocking a thread,
+* so a few workers can serve far more "threads" than CreateMonoThreads could.
 */
-class DILogger
+utils::Task<void> RunMonoCoroutine(utils::Scheduler& scheduler, int index)
 {
-public:
-	DILogger() = default;
-	void Log(const std::string& message)
+	MonoLogger logger{};
+
+	for (int i = 0; i < 5; ++i)
 	{
-		fmt::print("{}{}\n", sPrefix, message);
+		logger.Log("Message: {} from coroutine {}", i, index);
+		co_await scheduler.Sleep(std::chrono::milliseconds(100));
 	}
-private:
-	std::string sPrefix{ "[LOG]: " };
-};
 
-/*
-* Now we just pass in the logger to another class
-* as a dependency.
-*/
-class Service
+	// Wait until our lines are on stdout, without holding up a worker meanwhile
+	co_await logger.FlushAsync(scheduler);
+}
+
+/* File I/O the same way: the coroutine waits, the I/O thread does the blocking. */
+utils::Task<void> WriteCoroutineReport(utils::Scheduler& scheduler, int coroutineCount)
 {
-public:
-	Service(DILogger& logger) : logger{logger} {}
+	co_await scheduler.WriteFile("coroutines.txt",
+		fmt::format("{} coroutines shared {} worker threads", coroutineCount, scheduler.WorkerCount()));
 
-	void DoSomething()
-	{
-		logger.Log("Dependency Injection in action!");
-	}
+	const std::string report = co_await scheduler.ReadFile("coroutines.txt");
+	MonoLogger{}.Log("Read back from coroutines.txt: {}", report);
+}
 
-private:
-	DILogger& logger;
-};
+void CreateMonoCoroutines()
+{
+	constexpr int coroutineCount = 1000;
+
+	utils::Scheduler scheduler{ 4 };
+	std::vector<utils::Task<void>> coroutines;
+	coroutines.reserve(coroutineCount);
+	for (int i = 0; i < coroutineCount; ++i)
+		coroutines.push_back(RunMonoCoroutine(scheduler, i));
+
+	// One task that finishes when all of them have, waited for from this (non-coroutine) thread
+	scheduler.SyncWait(utils::WhenAll(scheduler, std::move(coroutines)));
+
+	// Fire and forget, WaitIdle() is how we know it is done
+	scheduler.Spawn(WriteCoroutineReport(scheduler, coroutineCount));
+	scheduler.WaitIdle();
+	MonoLogger{}.Sync();
+}
 
 void RunDependencyInjection()
 {
-	DILogger logger{};
+	DILogger<> logger{};
 	Service service{ logger };
 	service.DoSomething();
+
+	// Same service, different sink. Nothing else changes and nothing is virtual.
+	DILogger<BufferedSink<>> bufferedLogger{};
+	Service bufferedService{ bufferedLogger };
+	bufferedService.DoSomething();
+	bufferedLogger.LogBatch(std::array{ "Buffered lines", "share one prefix", "and one write." });
+	bufferedLogger.Flush();
 }
 
 /*
 * What if we don't want to pass along the dependencies manually?
 */
 
-/*
-* Service Locator
-* - Hides the complexity of dependency injection while avoiding the issues 
-* of a singleton.
-* 
-* Pros:
-* - Flexible!
-* - Can swap services easily.
-* - Less boilerplate than pure DI
-* 
-* Cons:
-* - Still kinda global
-* - Still some hidden dependencies.
-* - 
-*/
-
-class ServiceLocator
-{
-public:
-	template <typename T>
-	static void Provide(std::shared_ptr<T> service)
-	{
-		instance<T>() = std::move(service);
-	}
-
-	template <typename T>
-	static T& Get()
-	{
-		return *instance<T>();
-	}
-
-private:
-	template <typename T>
-	static std::shared_ptr<T>& instance()
-	{
-		static std::shared_ptr<T> serviceInstance;
-		return serviceInstance;
-	}
-};
-
 /*
 * Now we can register services dynamically
 */
@@ -211,10 +129,10 @@ private:
 void RunServiceLocator()
 {
 	/* We provide the logger to the service locator. */
-	ServiceLocator::Provide<DILogger>(std::make_shared<DILogger>());
+	ServiceLocator::Provide<DILogger<>>(std::make_shared<DILogger<>>());
 
 	/* Get the logger when we need it. */
-	auto& logger = ServiceLocator::Get<DILogger>();
+	auto& logger = ServiceLocator::Get<DILogger<>>();
 	logger.Log("Service locator in Action!");
 }
 
@@ -233,6 +151,8 @@ int main()
 {
 	RunSingletonLogger();
 	RunMonostateLogger();
+	CreateMonoThreads();
+	CreateMonoCoroutines();
 	RunDependencyInjection();
 	RunServiceLocator();
 	return 0;
@@ -0,0 +1,448 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "../Utilities/coro_runtime.hpp"
+#include "../Utilities/lock_profiler.hpp"
+#include "../Utilities/log_format.hpp"
+#include "../Utilities/singleton_registry.hpp"
+#include "../Utilities/tracing.hpp"
+#include "log_sinks.hpp"
+
+/*
+* Singleton Pattern
+* - Ensures only one instance of a class exists
+* - Global acces to that instance
+*/
+class Logger
+{
+public:
+	/*
+	* A function-local static would check its init guard on every call.
+	* utils::Singleton is a single pointer load, and tears down in a known order.
+	*/
+	static Logger& GetInstance()
+	{
+		return utils::Singleton<Logger>::Get();
+	}
+
+	/*
+	* Log("Spawned {} goblins", count), see utils::AppendFormatted.
+	* A "{}" count that doesn't match the arguments is a compile error.
+	*/
+	template <typename... Args>
+	void Log(utils::LogPattern<Args...> message, const Args&... args)
+	{
+		TRACE_SCOPE("Logger::Log");
+		fmt::memory_buffer line;
+		line.append(std::string_view{ "[LOG]: " });
+		utils::AppendFormatted(line, message, args...);
+		line.push_back('\n');
+		std::fwrite(line.data(), 1, line.size(), stdout);
+	}
+
+	// Called once more at teardown
+	void Flush() { std::fflush(stdout); }
+
+	/* co_await logger.FlushAsync(scheduler); -> Flush() on an I/O thread, no worker blocks on it */
+	utils::Task<void> FlushAsync(utils::Scheduler& scheduler)
+	{
+		co_await scheduler.Offload([this] { Flush(); });
+	}
+
+private:
+	friend class utils::Singleton<Logger>;
+
+	Logger() = default;
+	~Logger() = default;
+	Logger(const Logger&) = delete;
+	Logger& operator=(const Logger&) = delete;
+};
+
+/*
+* The Monostate Pattern
+* 
+* - Looks like a regular class, but under the hood, it shares state between instances
+* - Here, every logger object shares the same state. But unlike singletons, Monostate
+* can be copied and moved.
+* 
+* Pros:
+* - Easier to test 
+* - Still a single global state
+* - No need for GetInstance()
+* 
+* Cons:
+* - Still hidden dependencies
+* - Global state is still global
+* 
+* Shared state doesn't have to mean one shared lock though. Here the state is split
+* into shards, one per group of threads, and a background thread merges them onto
+* stdout. Call Sync() when you need to see everything logged so far.
+*/
+class MonoLogger
+{
+public:
+	/*
+	* Appends to this thread's shard. Nothing global is touched, so threads on
+	* different shards never wait on each other.
+	* The line is formatted straight into the shard's buffer, no temporary string.
+	*/
+	template <typename... Args>
+	void Log(utils::LogPattern<Args...> message, const Args&... args)
+	{
+		StartFlusher();
+
+		Shard& shard = shared.shards[ShardIndex()];
+		bool bWakeFlusher{ false };
+		{
+			std::lock_guard lock{ shard.mutex };
+			const auto offset = static_cast<std::uint32_t>(shard.buffer.size());
+			shard.buffer.append(kPrefix);
+			utils::AppendFormatted(shard.buffer, message, args...);
+			shard.buffer.push_back('\n');
+			shard.entries.push_back({
+				std::chrono::steady_clock::now().time_since_epoch().count(),
+				offset,
+				static_cast<std::uint32_t>(shard.buffer.size() - offset) });
+			bWakeFlusher = shard.buffer.size() >= kFlushBytes && !shard.bFlushRequested;
+			shard.bFlushRequested |= bWakeFlusher;
+		}
+
+		if (bWakeFlusher)
+			shared.flushCondition.notify_one();
+	}
+
+	/*
+	* Writes out everything logged so far (by any instance, on any thread)
+	* in timestamp order. When this returns, every Log() call that finished
+	* before it is on stdout.
+	*/
+	void Sync()
+	{
+		shared.Flush();
+	}
+
+	/* co_await logger.FlushAsync(scheduler); -> Sync() on an I/O thread, no worker blocks on it */
+	utils::Task<void> FlushAsync(utils::Scheduler& scheduler)
+	{
+		co_await scheduler.Offload([this] { Sync(); });
+	}
+
+private:
+	static constexpr std::size_t kShardCount{ 16 };
+	static constexpr std::size_t kFlushBytes{ 64 * 1024 };
+	static constexpr std::string_view kPrefix{ "[LOG]: " };
+
+	struct Entry
+	{
+		std::int64_t ticks;	// steady_clock, to merge the shards back in order
+		std::uint32_t offset;
+		std::uint32_t length;
+	};
+
+	// One cache line (or more) each, so neighbouring shards don't false share
+	struct alignas(64) Shard
+	{
+		utils::ProfiledMutex mutex{ "MonoLogger::Shard" };
+		std::string buffer;
+		std::vector<Entry> entries;
+		bool bFlushRequested{ false };
+	};
+
+	struct SharedState
+	{
+		~SharedState()
+		{
+			if (flusher.joinable())
+			{
+				{
+					std::lock_guard lock{ flushMutex };
+					bStop = true;
+				}
+				flushCondition.notify_one();
+				flusher.join();
+			}
+			Flush();
+		}
+
+		/*
+		* Takes a cut at 'now' and writes every entry stamped at or before it.
+		* Anything logged after a shard has been visited is stamped at or after
+		* the cut, so it goes out with the next flush and the output stays ordered.
+		* Entries in the same clock tick as the cut go out now: with a coarse clock
+		* (100ns on Windows) a Log() that finished right before Sync() can share its tick.
+		*/
+		void Flush()
+		{
+			std::lock_guard flushLock{ flushMutex };
+			const std::int64_t cut = std::chrono::steady_clock::now().time_since_epoch().count();
+
+			struct Pending
+			{
+				std::int64_t ticks;
+				std::size_t shard;
+				std::uint32_t offset;
+				std::uint32_t length;
+			};
+			std::vector<Pending> pending;
+
+			for (std::size_t i = 0; i < kShardCount; ++i)
+			{
+				Shard& shard = shards[i];
+				std::string& taken = drained[i];
+				taken.clear();
+
+				std::lock_guard lock{ shard.mutex };
+				shard.bFlushRequested = false;
+				if (shard.entries.empty())
+					continue;
+
+				// Entries in a shard are already in time order
+				const auto split = std::partition_point(shard.entries.begin(), shard.entries.end(),
+					[cut](const Entry& entry) { return entry.ticks <= cut; });
+				for (auto it = shard.entries.begin(); it != split; ++it)
+					pending.push_back({ it->ticks, i, it->offset, it->length });
+
+				/*
+				* Trade buffers: the shard gets the empty one drained last time, which
+				* keeps its capacity, so Log() doesn't regrow from nothing after every flush.
+				*/
+				taken.swap(shard.buffer);
+
+				// Copy the (rare) entries newer than the cut back, and trim the entries in place
+				auto kept = shard.entries.begin();
+				for (auto it = split; it != shard.entries.end(); ++it, ++kept)
+				{
+					const auto offset = static_cast<std::uint32_t>(shard.buffer.size());
+					shard.buffer.append(taken, it->offset, it->length);
+					*kept = { it->ticks, offset, it->length };
+				}
+				shard.entries.erase(kept, shard.entries.end());
+			}
+
+			if (pending.empty())
+				return;
+
+			std::stable_sort(pending.begin(), pending.end(),
+				[](const Pending& a, const Pending& b) { return a.ticks < b.ticks; });
+
+			output.clear();
+			for (const Pending& entry : pending)
+				output.append(drained[entry.shard], entry.offset, entry.length);
+
+			std::fwrite(output.data(), 1, output.size(), stdout);
+			std::fflush(stdout);
+		}
+
+		void FlushLoop()
+		{
+			std::unique_lock lock{ flushMutex };
+			while (!bStop)
+			{
+				flushCondition.wait_for(lock, std::chrono::milliseconds(50));
+				if (bStop)
+					break;
+
+				lock.unlock();
+				Flush();
+				lock.lock();
+			}
+		}
+
+		std::array<Shard, kShardCount> shards{};
+
+		// Owned by whoever holds flushMutex
+		std::mutex flushMutex;
+		std::condition_variable flushCondition;
+		std::array<std::string, kShardCount> drained{};
+		std::string output;
+		bool bStop{ false };
+
+		std::atomic<std::size_t> nextShard{ 0 };
+		std::atomic<bool> bFlusherStarted{ false };
+		std::once_flag flusherOnce;
+		std::thread flusher;
+	};
+
+	/* Threads are handed shards round robin the first time they log. */
+	static std::size_t ShardIndex()
+	{
+		thread_local const std::size_t index{
+			shared.nextShard.fetch_add(1, std::memory_order_relaxed) % kShardCount
+		};
+		return index;
+	}
+
+	/* The flusher thread is only started once someone actually logs. */
+	static void StartFlusher()
+	{
+		if (shared.bFlusherStarted.load(std::memory_order_acquire))
+			return;
+
+		std::call_once(shared.flusherOnce, []
+			{
+				shared.flusher = std::thread{ &SharedState::FlushLoop, &shared };
+				shared.bFlusherStarted.store(true, std::memory_order_release);
+			});
+	}
+
+	// Shared state
+	static SharedState shared;
+};
+
+// Defined out here because SharedState has to be complete first
+inline MonoLogger::SharedState MonoLogger::shared{};
+
+/*
+* Dependency Injection
+* We can pass in any dependencies that we need.
+* Pros:
+* - Testable(Pass a fake logger)
+* - No global state!
+* - More control
+* 
+* Cons:
+* - More boilerplate
+* - You have to pass dependencies manually.
+* 
+* The dependency here is the sink (see log_sinks.hpp), picked at compile time.
+* DILogger<NullSink> in a test or benchmark really does nothing at all,
+* and DILogger<FileSink> never pays for a virtual call to reach the file.
+*/
+template <LogSink Sink = StdoutSink>
+class DILogger
+{
+public:
+	static constexpr std::string_view kPrefix{ "[LOG]: " };
+
+	// Any arguments go to the sink, e.g. DILogger<FileSink> logger{ "log.txt" };
+	template <typename... Args>
+		requires std::constructible_from<Sink, Args...>
+	explicit DILogger(Args&&... args) : sink{ std::forward<Args>(args)... } {}
+
+	/* One line, handed to the sink in a single Write(). */
+	template <typename... Args>
+	void Log(utils::LogPattern<Args...> message, const Args&... args)
+	{
+		// With the else, NullSink never even instantiates the formatting
+		if constexpr (std::is_same_v<Sink, NullSink>)
+		{
+			return;
+		}
+		else
+		{
+			fmt::memory_buffer line;
+			line.append(kPrefix);
+			utils::AppendFormatted(line, message, args...);
+			line.push_back('\n');
+			sink.Write({ line.data(), line.size() });
+		}
+	}
+
+	/*
+	* Several lines under one prefix, also in a single Write():
+	* [LOG]: first
+	* second
+	*/
+	template <std::ranges::input_range Messages>
+		requires std::convertible_to<std::ranges::range_reference_t<Messages>, std::string_view>
+	void LogBatch(const Messages& messages)
+	{
+		if constexpr (std::is_same_v<Sink, NullSink>)
+		{
+			return;
+		}
+		else
+		{
+			fmt::memory_buffer batch;
+			batch.append(kPrefix);
+			for (std::string_view message : messages)
+			{
+				utils::AppendEscaped(batch, message);
+				batch.push_back('\n');
+			}
+			sink.Write({ batch.data(), batch.size() });
+		}
+	}
+
+	void Flush() { sink.Flush(); }
+	Sink& GetSink() { return sink; }
+
+private:
+	Sink sink;
+};
+
+/*
+* Now we just pass in the logger to another class
+* as a dependency. The sink type comes along, so Service<NullSink> is a
+* Service whose logging is compiled out.
+*/
+template <LogSink Sink = StdoutSink>
+class Service
+{
+public:
+	Service(DILogger<Sink>& logger) : logger{logger} {}
+
+	void DoSomething()
+	{
+		TRACE_SCOPE("Service::DoSomething");
+		logger.Log("Dependency Injection in action!");
+	}
+
+private:
+	DILogger<Sink>& logger;
+};
+
+/*
+* Service Locator
+* - Hides the complexity of dependency injection while avoiding the issues 
+* of a singleton.
+* 
+* Pros:
+* - Flexible!
+* - Can swap services easily.
+* - Less boilerplate than pure DI
+* 
+* Cons:
+* - Still kinda global
+* - Still some hidden dependencies.
+* - 
+*/
+
+class ServiceLocator
+{
+public:
+	template <typename T>
+	static void Provide(std::shared_ptr<T> service)
+	{
+		instance<T>() = std::move(service);
+	}
+
+	template <typename T>
+	static T& Get()
+	{
+		return *instance<T>();
+	}
+
+private:
+	template <typename T>
+	static std::shared_ptr<T>& instance()
+	{
+		static std::shared_ptr<T> serviceInstance;
+		return serviceInstance;
+	}
+};
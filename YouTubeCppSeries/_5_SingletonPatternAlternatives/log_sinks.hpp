@@ -0,0 +1,248 @@
+#pragma once
+#include <concepts>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#include <fmt/format.h>
+
+/*
+* Log Sinks
+* - A sink is where a logger's text ends up. Anything with Write(text) and Flush()
+* is a sink, the LogSink concept checks that at compile time.
+* - The logger is templated on its sink, so every call is direct (and usually inlined).
+* No virtual functions, no std::function, nothing to look up at runtime.
+*/
+template <typename T>
+concept LogSink = requires(T & sink, std::string_view text)
+{
+	{ sink.Write(text) } -> std::same_as<void>;
+	{ sink.Flush() } -> std::same_as<void>;
+};
+
+/* Throws everything away. A logger using it compiles down to nothing. */
+struct NullSink
+{
+	constexpr void Write(std::string_view) noexcept {}
+	constexpr void Flush() noexcept {}
+};
+
+/* Straight to stdout, one fwrite per Write(). */
+struct StdoutSink
+{
+	void Write(std::string_view text)
+	{
+		std::fwrite(text.data(), 1, text.size(), stdout);
+	}
+
+	void Flush() { std::fflush(stdout); }
+};
+
+/*
+* Appends to a file. The file stays open for the sink's lifetime (RAII).
+* NOTE: FILE* does its own buffering, call Flush() when you need it on disk.
+*/
+class FileSink
+{
+public:
+	explicit FileSink(const std::filesystem::path& path)
+		: pFile{ std::fopen(path.string().c_str(), "ab") }
+	{
+		if (!pFile)
+			throw std::runtime_error(fmt::format("Failed to open file [{}]", path.string()));
+	}
+
+	~FileSink()
+	{
+		if (pFile)
+			std::fclose(pFile);
+	}
+
+	FileSink(FileSink&& other) noexcept : pFile{ std::exchange(other.pFile, nullptr) } {}
+	FileSink& operator=(FileSink&& other) noexcept
+	{
+		if (this != &other)
+		{
+			if (pFile)
+				std::fclose(pFile);
+			pFile = std::exchange(other.pFile, nullptr);
+		}
+		return *this;
+	}
+	FileSink(const FileSink&) = delete;
+	FileSink& operator=(const FileSink&) = delete;
+
+	void Write(std::string_view text)
+	{
+		std::fwrite(text.data(), 1, text.size(), pFile);
+	}
+
+	void Flush()
+	{
+		// fflush(nullptr) would flush every open stream, not what a moved-from sink should do
+		if (pFile)
+			std::fflush(pFile);
+	}
+
+private:
+	std::FILE* pFile{ nullptr };
+};
+
+/*
+* Collects text in memory and hands it to the next sink in one Write(),
+* either on Flush() or once 'capacity' bytes have piled up.
+*/
+template <LogSink Next = StdoutSink>
+class BufferedSink
+{
+public:
+	explicit BufferedSink(std::size_t inCapacity = 64 * 1024, Next inNext = Next{})
+		: capacity{ inCapacity }, next{ std::move(inNext) }
+	{
+		sBuffer.reserve(capacity);
+	}
+
+	// Whatever is still buffered goes to the next sink, it flushes itself when it closes
+	~BufferedSink() { Drain(); }
+
+	BufferedSink(BufferedSink&& other) noexcept
+		: capacity{ other.capacity }
+		, sBuffer{ std::exchange(other.sBuffer, {}) }
+		, next{ std::move(other.next) }
+	{
+	}
+	BufferedSink& operator=(BufferedSink&&) = delete;
+	BufferedSink(const BufferedSink&) = delete;
+	BufferedSink& operator=(const BufferedSink&) = delete;
+
+	void Write(std::string_view text)
+	{
+		sBuffer.append(text);
+		if (sBuffer.size() >= capacity)
+			Drain();
+	}
+
+	void Flush()
+	{
+		Drain();
+		next.Flush();
+	}
+
+	/* What is waiting to be written, handy for tests. */
+	std::string_view Pending() const { return sBuffer; }
+	Next& GetNext() { return next; }
+
+private:
+	void Drain()
+	{
+		if (sBuffer.empty())
+			return;
+		next.Write(sBuffer);
+		sBuffer.clear();
+	}
+
+	std::size_t capacity;
+	std::string sBuffer;
+	Next next;
+};
+
+/*
+* Hands text to a background thread that writes it to the next sink,
+* so the caller never waits on I/O.
+* - Write() only appends to a buffer under a short lock.
+* - The writer thread swaps that buffer out and writes it in one go.
+* - Flush() waits until everything written before it has reached the next sink.
+*/
+template <LogSink Next = StdoutSink>
+class AsyncSink
+{
+public:
+	explicit AsyncSink(Next inNext = Next{})
+		: next{ std::move(inNext) }
+		, writer{ [this] { WriterLoop(); } }
+	{
+	}
+
+	~AsyncSink()
+	{
+		{
+			std::lock_guard lock{ mutex };
+			bStop = true;
+		}
+		wakeWriter.notify_one();
+		writer.join();
+		next.Flush();
+	}
+
+	AsyncSink(const AsyncSink&) = delete;
+	AsyncSink& operator=(const AsyncSink&) = delete;
+
+	void Write(std::string_view text)
+	{
+		{
+			std::lock_guard lock{ mutex };
+			sPending.append(text);
+		}
+		wakeWriter.notify_one();
+	}
+
+	/* The writer thread does the flushing too, so only one thread ever touches 'next'. */
+	void Flush()
+	{
+		std::unique_lock lock{ mutex };
+		const std::uint64_t ticket = ++flushesRequested;
+		wakeWriter.notify_one();
+		flushed.wait(lock, [this, ticket] { return flushesDone >= ticket; });
+	}
+
+private:
+	void WriterLoop()
+	{
+		std::string sWriting;
+		std::unique_lock lock{ mutex };
+		for (;;)
+		{
+			wakeWriter.wait(lock,
+				[this] { return bStop || !sPending.empty() || flushesRequested != flushesDone; });
+
+			// Everything written before these flush requests is in this batch
+			const std::uint64_t serving = flushesRequested;
+			const bool bFlush = serving != flushesDone;
+			if (sPending.empty() && !bFlush && bStop)
+				break;
+
+			sWriting.swap(sPending);
+			lock.unlock();
+
+			if (!sWriting.empty())
+				next.Write(sWriting);
+			sWriting.clear();
+			if (bFlush)
+				next.Flush();
+
+			lock.lock();
+			if (bFlush)
+			{
+				flushesDone = serving;
+				flushed.notify_all();
+			}
+		}
+	}
+
+	Next next;
+	std::mutex mutex;
+	std::condition_variable wakeWriter;
+	std::condition_variable flushed;
+	std::string sPending;
+	std::uint64_t flushesRequested{ 0 };
+	std::uint64_t flushesDone{ 0 };
+	bool bStop{ false };
+	std::thread writer;				// Last, so everything above exists before it starts
+};
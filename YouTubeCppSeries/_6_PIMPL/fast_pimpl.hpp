@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace pimplTests
+{
+	/*
+	* Fast PIMPL
+	* - A regular PIMPL pays for a heap allocation per object and a pointer chase per call.
+	* - Here the Impl lives in aligned storage inside the public class itself.
+	* - The header still only needs a forward declaration of Impl. Size and Align are
+	* checked with a static_assert where Impl is complete (the .cpp), so if the Impl
+	* grows, the build fails instead of corrupting memory.
+	*
+	* NOTE: Every member that touches the Impl (ctors, dtor, assignment) must be
+	* instantiated in the .cpp. Declare them in the public class and define them
+	* there, even if it is only "= default".
+	*/
+	template <typename Impl, std::size_t Size, std::size_t Align = alignof(std::max_align_t)>
+	class FastPimpl
+	{
+	public:
+		/* The constraint keeps this from hijacking copies of non-const objects. */
+		template <typename... Args>
+			requires (sizeof...(Args) != 1 || !(std::is_same_v<std::remove_cvref_t<Args>, FastPimpl> && ...))
+		explicit FastPimpl(Args&&... args)
+		{
+			Validate<sizeof(Impl), alignof(Impl)>();
+			::new (static_cast<void*>(m_Storage)) Impl(std::forward<Args>(args)...);
+		}
+
+		FastPimpl(const FastPimpl& other)
+		{
+			::new (static_cast<void*>(m_Storage)) Impl(*other);
+		}
+
+		FastPimpl(FastPimpl&& other) noexcept
+		{
+			static_assert(std::is_nothrow_move_constructible_v<Impl>, "Impl must be nothrow move constructible");
+			::new (static_cast<void*>(m_Storage)) Impl(std::move(*other));
+		}
+
+		FastPimpl& operator=(const FastPimpl& other)
+		{
+			if (this != &other)
+				**this = *other;
+			return *this;
+		}
+
+		FastPimpl& operator=(FastPimpl&& other) noexcept
+		{
+			**this = std::move(*other);
+			return *this;
+		}
+
+		~FastPimpl()
+		{
+			Validate<sizeof(Impl), alignof(Impl)>();
+			Get()->~Impl();
+		}
+
+		Impl* operator->() noexcept { return Get(); }
+		const Impl* operator->() const noexcept { return Get(); }
+		Impl& operator*() noexcept { return *Get(); }
+		const Impl& operator*() const noexcept { return *Get(); }
+
+	private:
+		/*
+		* Taking the real size and alignment as template parameters puts the actual
+		* numbers in the compiler error, so you know what to change Size/Align to.
+		*/
+		template <std::size_t ActualSize, std::size_t ActualAlign>
+		static constexpr void Validate() noexcept
+		{
+			static_assert(Size >= ActualSize, "FastPimpl: Size is too small for Impl");
+			static_assert(Align % ActualAlign == 0, "FastPimpl: Align does not satisfy Impl's alignment");
+		}
+
+		Impl* Get() noexcept { return std::launder(reinterpret_cast<Impl*>(m_Storage)); }
+		const Impl* Get() const noexcept { return std::launder(reinterpret_cast<const Impl*>(m_Storage)); }
+
+		alignas(Align) std::byte m_Storage[Size];
+	};
+}
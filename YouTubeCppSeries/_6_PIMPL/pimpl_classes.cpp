@@ -2,6 +2,16 @@
 #include <iostream>
 #include <fstream>
 #include <mutex>
+#include <optional>
+#include <algorithm>
+#include <stdexcept>
+#include <fmt/format.h>
+
+#include "../Utilities/crash_drain.hpp"
+#include "../Utilities/lock_profiler.hpp"
+#include "../Utilities/singleton_registry.hpp"
+#include "../Utilities/thread_pool.hpp"
+#include "../Utilities/tracing.hpp"
 
 namespace pimplTests 
 {
@@ -9,15 +19,24 @@ namespace pimplTests
 class Person::Impl
 {
 public:
-	Impl(const std::string name, int age)
-		: m_Name{ name }, m_Age{ age }
+	Impl(std::string name, int age)
+		: m_Name{ std::move(name) }, m_Age{ age }
 	{
 
 	}
 
-	void Introduce() const
+	static constexpr std::string_view kIntroduction{ "Hello, I'm {} and I'm {} years old.\n" };
+
+	// Exact number of characters FormatIntroduction will write
+	std::size_t IntroductionSize() const
+	{
+		// The two "{}" placeholders are replaced
+		return kIntroduction.size() - 4 + m_Name.size() + fmt::formatted_size("{}", m_Age);
+	}
+
+	char* FormatIntroduction(char* out) const
 	{
-		std::cout << "Hello, I'm " << m_Name << " and I'm " << m_Age << " years old.\n";
+		return fmt::format_to(out, kIntroduction, m_Name, m_Age);
 	}
 
 private:
@@ -26,16 +45,79 @@ private:
 };
 
 // Forward constructor calls to Impl
-Person::Person(const std::string& name, int age)
-	: m_pImpl{ std::make_unique<Person::Impl>(name, age)}
+Person::Person(std::string name, int age)
+	: m_pImpl{ std::move(name), age }
 {
 }
 
+Person::Person(const Person& other) = default;
+Person::Person(Person&& other) noexcept = default;
+Person& Person::operator=(const Person& other) = default;
+Person& Person::operator=(Person&& other) noexcept = default;
 Person::~Person() = default;
 
 void Person::Introduce() const
 {
-	m_pImpl->Introduce();
+	IntroduceAll({ this, 1 });
+}
+
+std::vector<Person> Person::CreateMany(std::span<std::string> names, std::span<const int> ages)
+{
+	if (names.size() != ages.size())
+	{
+		throw std::invalid_argument(
+			fmt::format("CreateMany: {} names but {} ages", names.size(), ages.size()));
+	}
+
+	std::vector<Person> people;
+	people.reserve(names.size());
+	for (std::size_t i = 0; i < names.size(); ++i)
+	{
+		people.emplace_back(std::move(names[i]), ages[i]);
+	}
+
+	return people;
+}
+
+void Person::IntroduceAll(std::span<const Person> people)
+{
+	// Below this many people, handing work to other threads costs more than it saves
+	constexpr std::size_t kParallelThreshold{ 1 << 14 };
+
+	// Work out where every introduction goes so the buffer is allocated once
+	std::vector<std::size_t> offsets(people.size() + 1, 0);
+	for (std::size_t i = 0; i < people.size(); ++i)
+	{
+		offsets[i + 1] = offsets[i] + people[i].m_pImpl->IntroductionSize();
+	}
+
+	std::string buffer(offsets.back(), '\0');
+	auto formatRange = [&](std::size_t begin, std::size_t end)
+	{
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			people[i].m_pImpl->FormatIntroduction(buffer.data() + offsets[i]);
+		}
+	};
+
+	if (people.size() < kParallelThreshold)
+	{
+		formatRange(0, people.size());
+	}
+	else
+	{
+		// Every chunk writes into its own slice of the buffer, no locking needed
+		const std::size_t chunkCount = (people.size() + kParallelThreshold - 1) / kParallelThreshold;
+		utils::DefaultThreadPool().ParallelFor(std::size_t{ 0 }, chunkCount,
+			[&](std::size_t chunk)
+			{
+				const std::size_t begin = chunk * kParallelThreshold;
+				formatRange(begin, std::min(begin + kParallelThreshold, people.size()));
+			},
+			std::size_t{ 1 });
+	}
+
+	std::cout.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
 }
 
 
@@ -44,7 +126,7 @@ class Logger::Impl
 public:
 	Impl()
 	{
-		m_LogFile.open("log.txt", std::ios::app);
+		m_LogFile.open(m_Path, std::ios::app);
 	}
 	~Impl()
 	{
@@ -56,7 +138,30 @@ public:
 
 	void Log(const std::string& message)
 	{
+		TRACE_SCOPE("pimplTests::Logger::Log");
 		std::lock_guard lock{ m_Mutex };
+		if (m_Console)
+		{
+			// One Append per line, so a crash or a full buffer never splits a line
+			constexpr std::string_view kPrefix{ "[LOG]: " };
+			fmt::memory_buffer line;
+			line.append(kPrefix);
+			line.append(message);
+			line.push_back('\n');
+			const std::string_view text{ line.data(), line.size() };
+
+			m_Console->Append(text);
+			if (m_File)
+			{
+				m_File->Append(text.substr(kPrefix.size()));
+			}
+			else if (m_LogFile.is_open())
+			{
+				m_LogFile << message << '\n';
+			}
+			return;
+		}
+
 		std::cout << "[LOG]: " << message << std::endl;
 		if (m_LogFile.is_open())
 		{
@@ -64,18 +169,80 @@ public:
 		}
 	}
 
+	void Flush()
+	{
+		std::lock_guard lock{ m_Mutex };
+		std::cout.flush();
+		if (m_LogFile.is_open())
+		{
+			m_LogFile.flush();
+		}
+		if (m_Console)
+		{
+			m_Console->Flush();
+		}
+		if (m_File)
+		{
+			m_File->Flush();
+		}
+	}
+
+	void EnableCrashSafety(std::size_t bufferSize)
+	{
+		std::lock_guard lock{ m_Mutex };
+		if (m_Console)
+		{
+			return;
+		}
+
+		// Everything written so far goes out first, so the order stays the same
+		std::cout.flush();
+		m_BufferSize = bufferSize;
+		m_Console.emplace(utils::kStdoutFd, bufferSize, false);
+
+		// The log file moves to a file descriptor opened now, a crash can't open files
+		if (const int fd = utils::OpenDrainFile(m_Path.c_str()); fd >= 0)
+		{
+			m_LogFile.close();
+			m_File.emplace(fd, bufferSize, true);
+		}
+	}
+
+	void SetLogFile(const std::string& path)
+	{
+		std::lock_guard lock{ m_Mutex };
+		m_Path = path;
+		m_LogFile.close();
+		if (m_File)
+		{
+			// Flushes and closes the old file
+			m_File.reset();
+			if (const int fd = utils::OpenDrainFile(m_Path.c_str()); fd >= 0)
+			{
+				m_File.emplace(fd, m_BufferSize, true);
+				return;
+			}
+		}
+		m_LogFile.open(m_Path, std::ios::app);
+	}
+
 private:
+	std::string m_Path{ "log.txt" };
 	std::ofstream m_LogFile;
-	std::mutex m_Mutex;
+	utils::ProfiledMutex m_Mutex{ "Logger::Impl::m_Mutex" };
+
+	// Only set in crash-safe mode
+	std::size_t m_BufferSize{ 0 };
+	std::optional<utils::DrainBuffer> m_Console;
+	std::optional<utils::DrainBuffer> m_File;
 };
 
 Logger& Logger::GetInstance()
 {
-	static Logger instance{};
-	return instance;
+	return utils::Singleton<Logger>::Get();
 }
 
-Logger::Logger() : m_pImpl{ std::make_unique<Logger::Impl>() }
+Logger::Logger() : m_pImpl{}
 {
 
 }
@@ -86,4 +253,19 @@ void Logger::Log(const std::string& message)
 	m_pImpl->Log(message);
 }
 
+void Logger::Flush()
+{
+	m_pImpl->Flush();
+}
+
+void Logger::EnableCrashSafety(std::size_t bufferSize)
+{
+	m_pImpl->EnableCrashSafety(bufferSize);
+}
+
+void Logger::SetLogFile(const std::string& path)
+{
+	m_pImpl->SetLogFile(path);
+}
+
 } 
\ No newline at end of file
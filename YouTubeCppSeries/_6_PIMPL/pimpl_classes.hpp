@@ -1,6 +1,15 @@
 #pragma once
-#include <memory>
+#include <cstddef>
 #include <string>
+#include <span>
+#include <vector>
+#include "fast_pimpl.hpp"
+
+namespace utils
+{
+	template <typename T>
+	class Singleton;
+}
 
 namespace pimplTests
 {
@@ -8,29 +17,66 @@ namespace pimplTests
 	class Person
 	{
 	public:
-		Person(const std::string& name, int age);
-		~Person(); // Required for a unique_ptr with an incomplete type
+		// Taken by value so callers can move the name all the way into the Impl
+		Person(std::string name, int age);
+		// All of these touch the Impl, so they must be defined in the .cpp
+		Person(const Person& other);
+		Person(Person&& other) noexcept;
+		Person& operator=(const Person& other);
+		Person& operator=(Person&& other) noexcept;
+		~Person();
 
 		void Introduce() const;
 
+		/*
+		* Bulk API
+		* - CreateMany moves the names out of the span, so they are not copied.
+		* - IntroduceAll formats everyone into a single buffer and writes it once.
+		* Large batches are formatted in parallel chunks.
+		*/
+		static std::vector<Person> CreateMany(std::span<std::string> names, std::span<const int> ages);
+		static void IntroduceAll(std::span<const Person> people);
+
 	private:
 		class Impl;
-		std::unique_ptr<Impl> m_pImpl;
+		// The Impl is stored inline, no heap allocation per Person
+		FastPimpl<Impl, 48, alignof(void*)> m_pImpl;
 	};
 
 	class Logger
 	{
 	public:
+		/*
+		* A single pointer load (see utils::Singleton). It stays in the .cpp so the
+		* instance lives in one module, even when the library is a Windows DLL.
+		*/
 		static Logger& GetInstance();
 		void Log(const std::string& message);
 
+		/* Pushes the console and log.txt out. Also runs once at teardown. */
+		void Flush();
+
+		/*
+		* Switches from a write per line to buffered writes, bufferSize bytes per output.
+		* If the process crashes (SIGSEGV, SIGABRT, SIGTERM) whatever is still buffered
+		* is written out by the signal handler first (see utils::DrainBuffer).
+		* NOTE: Buffered lines skip std::cout, so they can show up after console output
+		* that was printed later by someone else.
+		*/
+		void EnableCrashSafety(std::size_t bufferSize = 64 * 1024);
+
+		/* Appends to path from now on instead of log.txt. */
+		void SetLogFile(const std::string& path);
+
 	private:
+		friend class utils::Singleton<Logger>;
+
 		Logger(); // Private Ctor for singleton
 		~Logger();
 		Logger(const Logger&) = delete;
 		Logger& operator=(const Logger&) = delete;
 
 		class Impl;
-		std::unique_ptr<Impl> m_pImpl;
+		FastPimpl<Impl, 768> m_pImpl;
 	};
 }
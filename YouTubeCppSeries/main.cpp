@@ -1,33 +1,53 @@
 #include "_6_PIMPL/pimpl_classes.hpp"
-#include <thread>
+#include "Utilities/singleton_registry.hpp"
+#include "Utilities/thread_pool.hpp"
+#include "Utilities/tracing.hpp"
+#include <cstdlib>
 #include <vector>
-#include <format>
+#include <string>
+#include <string_view>
+#include <fmt/format.h>
 
-int main()
+int main(int argc, char** argv)
 {
 	pimplTests::Person person{ "Dustin", 40 };
 	person.Introduce();
+
+	// Bulk construction moves the names in, then everyone is introduced with one write
+	std::vector<std::string> names{ "Jadeite", "Nephrite", "Zoisite", "Kunzite" };
+	std::vector<int> ages{ 25, 27, 23, 30 };
+	auto people = pimplTests::Person::CreateMany(names, ages);
+	pimplTests::Person::IntroduceAll(people);
 	
-	std::vector<std::thread> threads;
-	for (int i = 0; i < 5; i++)
-	{
-		threads.emplace_back(
-			[i] 
+	// Lines are buffered from here on, and still written out if the process crashes
+	pimplTests::Logger::GetInstance().EnableCrashSafety();
+
+	// The pool's threads are created once and reused, instead of one thread per task
+	utils::ThreadPool pool{ 5 };
+	pool.ParallelFor(0, 5,
+		[](int i)
+		{
+			for (int j = 0; j < 5; j++)
 			{
-				for (int j = 0; j < 5; j++)
-				{
-					pimplTests::Logger::GetInstance().Log(
-						std::format("Thread {} - Message {}", i, j)
-					);
-				}
+				pimplTests::Logger::GetInstance().Log(
+					fmt::format("Task {} - Message {}", i, j)
+				);
 			}
-		);
-	}
+		},
+		1 // One index per task, so every task can run on its own worker
+	);
+
+	pimplTests::Logger::GetInstance().Log("All tasks are finished!");
+
+	// "ep6_pimpl --crash": the buffered lines above still make it to the console and log.txt
+	if (argc > 1 && std::string_view{ argv[1] } == "--crash")
+		std::abort();
 
-	for (auto& thread : threads)
-		thread.join();
+	// Every Logger::Log call above, on every pool thread, as one timeline
+	utils::Tracer::WriteChromeTrace("trace.json");
 
-	pimplTests::Logger::GetInstance().Log("All threads are finished!");
+	// Flush and destroy the singletons now, rather than somewhere inside exit()
+	utils::SingletonRegistry::Shutdown();
 
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,108 @@
+# ===================================================================================
+# Shared compile options for every target in the series.
+# Link against cppseries_options to pick up warnings, PGO and sanitizer flags.
+# ===================================================================================
+add_library(cppseries_options INTERFACE)
+
+if(MSVC)
+	target_compile_options(cppseries_options INTERFACE /W3 /utf-8 /permissive-)
+else()
+	target_compile_options(cppseries_options INTERFACE -Wall -Wextra)
+endif()
+
+# -----------------------------------------------------------------------------------
+# Tracing (TRACE_SCOPE compiles to nothing when this is off)
+# -----------------------------------------------------------------------------------
+if(CPPSERIES_TRACING)
+	target_compile_definitions(cppseries_options INTERFACE CPPSERIES_TRACING_ENABLED=1)
+else()
+	target_compile_definitions(cppseries_options INTERFACE CPPSERIES_TRACING_ENABLED=0)
+endif()
+
+# -----------------------------------------------------------------------------------
+# Link time optimization
+# -----------------------------------------------------------------------------------
+if(CPPSERIES_ENABLE_LTO)
+	include(CheckIPOSupported)
+	check_ipo_supported(RESULT bIPOSupported OUTPUT ipoError LANGUAGES CXX)
+	if(bIPOSupported)
+		set(CMAKE_INTERPROCEDURAL_OPTIMIZATION ON)
+	else()
+		message(WARNING "LTO was requested but is not supported: ${ipoError}")
+	endif()
+endif()
+
+# -----------------------------------------------------------------------------------
+# Profile guided optimization
+# 1) Configure with CPPSERIES_PGO=GENERATE, build and run the workloads (e.g. "bench").
+# 2) Reconfigure with CPPSERIES_PGO=USE pointing at the same CPPSERIES_PGO_DIR.
+# Clang needs the raw profiles merged first:
+#   llvm-profdata merge -o <dir>/default.profdata <dir>/*.profraw
+# -----------------------------------------------------------------------------------
+string(TOUPPER "${CPPSERIES_PGO}" CPPSERIES_PGO)
+if(CPPSERIES_PGO STREQUAL "GENERATE")
+	if(MSVC)
+		message(FATAL_ERROR "CPPSERIES_PGO is only wired up for GCC and Clang")
+	endif()
+	file(MAKE_DIRECTORY "${CPPSERIES_PGO_DIR}")
+	target_compile_options(cppseries_options INTERFACE "-fprofile-generate=${CPPSERIES_PGO_DIR}")
+	target_link_options(cppseries_options INTERFACE "-fprofile-generate=${CPPSERIES_PGO_DIR}")
+	if(CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
+		# Name profiles relative to the build dir so the USE build (in another dir) finds them
+		target_compile_options(cppseries_options INTERFACE "-fprofile-prefix-path=${CMAKE_BINARY_DIR}")
+	endif()
+elseif(CPPSERIES_PGO STREQUAL "USE")
+	if(MSVC)
+		message(FATAL_ERROR "CPPSERIES_PGO is only wired up for GCC and Clang")
+	endif()
+	if(CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+		target_compile_options(cppseries_options INTERFACE "-fprofile-use=${CPPSERIES_PGO_DIR}/default.profdata")
+	else()
+		target_compile_options(cppseries_options INTERFACE
+			"-fprofile-use=${CPPSERIES_PGO_DIR}" "-fprofile-prefix-path=${CMAKE_BINARY_DIR}"
+			-fprofile-correction -Wno-missing-profile)
+	endif()
+elseif(NOT CPPSERIES_PGO STREQUAL "OFF")
+	message(FATAL_ERROR "CPPSERIES_PGO must be OFF, GENERATE or USE (got '${CPPSERIES_PGO}')")
+endif()
+
+# -----------------------------------------------------------------------------------
+# Sanitizers
+# -----------------------------------------------------------------------------------
+if(CPPSERIES_SANITIZE)
+	if(MSVC)
+		target_compile_options(cppseries_options INTERFACE /fsanitize=address)
+	else()
+		list(JOIN CPPSERIES_SANITIZE "," sanitizers)
+		target_compile_options(cppseries_options INTERFACE
+			"-fsanitize=${sanitizers}" -fno-omit-frame-pointer -fno-sanitize-recover=all)
+		target_link_options(cppseries_options INTERFACE "-fsanitize=${sanitizers}")
+
+		# TSan can't model standalone atomic_thread_fence (the work-stealing deque and
+		# epoch reclamation use them). The fences are correct, GCC just says it can't check them.
+		if("thread" IN_LIST CPPSERIES_SANITIZE AND CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
+			target_compile_options(cppseries_options INTERFACE -Wno-tsan)
+		endif()
+	endif()
+endif()
+
+# -----------------------------------------------------------------------------------
+# Helpers
+# -----------------------------------------------------------------------------------
+
+# One executable per episode, each with its own main()
+function(cppseries_add_episode name)
+	add_executable(${name} ${ARGN})
+	target_link_libraries(${name} PRIVATE cppseries cppseries_options)
+endfunction()
+
+# cppseries_add_benchmark(<name> SOURCES <files...> [ARGS <args...>])
+# Builds a benchmark executable and registers it with the "bench" target.
+function(cppseries_add_benchmark name)
+	cmake_parse_arguments(PARSE_ARGV 1 BENCH "" "" "SOURCES;ARGS")
+	add_executable(${name} ${BENCH_SOURCES})
+	target_link_libraries(${name} PRIVATE cppseries cppseries_bench cppseries_options)
+
+	set_property(GLOBAL APPEND PROPERTY CPPSERIES_BENCH_TARGETS ${name})
+	set_property(GLOBAL APPEND PROPERTY CPPSERIES_BENCH_COMMANDS COMMAND $<TARGET_FILE:${name}> ${BENCH_ARGS})
+endfunction()